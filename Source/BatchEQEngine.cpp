@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+    Headless engine that runs many independent mono streams through the EQ in
+    one call, for offline rendering of stems.
+  ==============================================================================
+*/
+
+#include "BatchEQEngine.h"
+
+void BatchEQEngine::prepare(double newSampleRate, int maximumBlockSize, int numStreams)
+{
+    jassert(newSampleRate > 0 && maximumBlockSize > 0 && numStreams >= 0);
+
+    sampleRate = newSampleRate;
+
+    const auto numGroups = ((size_t)numStreams + width - 1) / width;
+
+    interleaved = juce::dsp::AudioBlock<Lanes>(interleavedData, numGroups, (size_t)maximumBlockSize);
+    interleaved.clear();
+
+    streamCoefficients.assign((size_t)numStreams, makeChainCoefficients(ChainSettings(), sampleRate));
+    cascades.resize(numGroups);
+    groupChanged.assign(numGroups, true);
+
+    reset();
+}
+
+void BatchEQEngine::reset()
+{
+    for (auto& cascade : cascades)
+        cascade.reset();
+}
+
+void BatchEQEngine::setSettings(const ChainSettings& chainSettings)
+{
+    std::fill(streamCoefficients.begin(), streamCoefficients.end(), makeChainCoefficients(chainSettings, sampleRate));
+    std::fill(groupChanged.begin(), groupChanged.end(), true);
+}
+
+void BatchEQEngine::setStreamSettings(int stream, const ChainSettings& chainSettings)
+{
+    jassert(juce::isPositiveAndBelow(stream, getNumStreams()));
+
+    streamCoefficients[(size_t)stream] = makeChainCoefficients(chainSettings, sampleRate);
+    groupChanged[(size_t)stream / width] = true;
+}
+
+void BatchEQEngine::applyCoefficients(size_t group)
+{
+    const auto firstStream = group * width;
+    const auto groupSize = juce::jmin(width, streamCoefficients.size() - firstStream);
+
+    std::array<ChainCoefficients, width> laneCoefficients;
+
+    for (size_t lane = 0; lane < width; ++lane)
+        laneCoefficients[lane] = streamCoefficients[firstStream + (lane < groupSize ? lane : 0)];
+
+    cascades[group].setCoefficients(laneCoefficients);
+    groupChanged[group] = false;
+}
+
+void BatchEQEngine::process(float* const* streams, int numStreams, int numSamples)
+{
+    jassert(numStreams <= getNumStreams());
+
+    const auto numUsed = (size_t)juce::jlimit(0, getNumStreams(), numStreams);
+    const auto capacity = interleaved.getNumSamples();
+
+    for (size_t firstStream = 0, group = 0; firstStream < numUsed; firstStream += width, ++group)
+    {
+        if (groupChanged[group])
+            applyCoefficients(group);
+
+        const auto groupSize = juce::jmin(width, numUsed - firstStream);
+
+        auto* frames = interleaved.getChannelPointer(group);
+        auto* lanes = reinterpret_cast<float*>(frames);
+
+        for (size_t start = 0; start < (size_t)numSamples; start += capacity)
+        {
+            auto count = juce::jmin(capacity, (size_t)numSamples - start);
+
+            for (size_t lane = 0; lane < groupSize; ++lane)
+            {
+                auto* stream = streams[firstStream + lane] + start;
+
+                for (size_t i = 0; i < count; ++i)
+                    lanes[i * width + lane] = stream[i];
+            }
+
+            // streams left out of this call, keep their lanes silent
+            for (size_t lane = groupSize; lane < width; ++lane)
+                for (size_t i = 0; i < count; ++i)
+                    lanes[i * width + lane] = 0.f;
+
+            cascades[group].process(frames, (int)count);
+
+            for (size_t lane = 0; lane < groupSize; ++lane)
+            {
+                auto* stream = streams[firstStream + lane] + start;
+
+                for (size_t i = 0; i < count; ++i)
+                    stream[i] = lanes[i * width + lane];
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+    Headless engine that runs many independent mono streams through the EQ in
+    one call, for offline rendering of stems.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <vector>
+
+#include "FilterDesign.h"
+#include "BiquadCascade.h"
+
+/**
+ Needs no processor, parameter tree or editor: give it ChainSettings directly,
+ either one set shared by every stream or a set per stream, then hand it the
+ streams' buffers.
+
+ Streams are stored structure-of-arrays, grouped SIMDRegister<float>::size()
+ at a time with one stream per lane, and each group runs through one
+ BiquadCascade. Lanes of a group can hold different designs, so per-stream
+ settings cost no more than shared ones. The lanes of a partly filled last
+ group, and of streams left out of a process() call, carry silence; padding
+ lanes copy their group's first design.
+
+ Settings changes are designed straight away but only applied to the groups
+ they touch at the start of the next process() call. None of the calls are
+ thread safe with each other.
+ */
+class BatchEQEngine
+{
+public:
+    void prepare(double sampleRate, int maximumBlockSize, int numStreams);
+    void reset();
+
+    void setSettings(const ChainSettings& chainSettings);
+    void setStreamSettings(int stream, const ChainSettings& chainSettings);
+
+    int getNumStreams() const { return (int)streamCoefficients.size(); }
+
+    // filters each streams[i] in place, for i < numStreams <= getNumStreams()
+    void process(float* const* streams, int numStreams, int numSamples);
+
+private:
+#if JUCE_USE_SIMD
+    using Lanes = juce::dsp::SIMDRegister<float>;
+#else
+    using Lanes = float;
+#endif
+
+    static constexpr size_t width = BiquadCascade<Lanes>::numLanes;
+
+    void applyCoefficients(size_t group);
+
+    double sampleRate = 44100.0;
+
+    std::vector<ChainCoefficients> streamCoefficients;
+    std::vector<BiquadCascade<Lanes>> cascades;
+    std::vector<bool> groupChanged;
+
+    // one channel per group, one frame of lanes per sample
+    juce::HeapBlock<char> interleavedData;
+    juce::dsp::AudioBlock<Lanes> interleaved;
+};
@@ -0,0 +1,453 @@
+/*
+  ==============================================================================
+    Console benchmark for the filter path, built from TokyoEQBenchmark.jucer.
+    Runs EQEngine, the same code processBlock runs, over a sweep of block
+    sizes, sample rates, slopes and bypass combinations. With --fft it times
+    the analyzer's FFT backends instead, with --spectrum its per-bin dB
+    conversion and with --response the editor's response curve.
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "EQEngine.h"
+#include "FFTBackend.h"
+#include "RealtimeSafety.h"
+#include "ResponseCurveEvaluator.h"
+#include "SpectrumMath.h"
+
+namespace
+{
+    struct BenchmarkOptions
+    {
+        juce::Array<EQEngine::ProcessingEngine> engines{ EQEngine::ScalarBiquad, EQEngine::SIMDChannels,
+                                                         EQEngine::FusedCascade, EQEngine::StateVariable };
+        int numChannels = 2;
+        int samplesPerRun = 1 << 18;   // per channel, for every combination
+        int controlRate = 32;
+        bool automate = false;         // retarget every block, so the smoother never settles
+        bool fft = false;              // time the analyzer FFT backends instead of the filters
+        bool spectrum = false;         // or the analyzer's magnitude to dB conversion
+        bool response = false;         // or the response curve
+    };
+
+    const char* getEngineName(EQEngine::ProcessingEngine engine)
+    {
+        switch (engine)
+        {
+        case EQEngine::SIMDChannels:    return "simd";
+        case EQEngine::FusedCascade:    return "fused";
+        case EQEngine::StateVariable:   return "svf";
+        case EQEngine::ScalarBiquad:
+        default:                        return "scalar";
+        }
+    }
+
+    ChainSettings makeSettings(Slope slope, int bypassMask)
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 80.f;
+        settings.highCutFreq = 12000.f;
+        settings.peakFreq = 1000.f;
+        settings.peakGainInDecibels = 6.f;
+        settings.peakQuality = 1.f;
+        settings.lowCutSlope = slope;
+        settings.highCutSlope = slope;
+
+        settings.lowCutBypassed = (bypassMask & 1) != 0;
+        settings.peakBypassed = (bypassMask & 2) != 0;
+        settings.highCutBypassed = (bypassMask & 4) != 0;
+
+        return settings;
+    }
+
+    // nanoseconds per sample and per channel
+    double runOne(const BenchmarkOptions& options, EQEngine::ProcessingEngine engineType,
+                  double sampleRate, int blockSize, const ChainSettings& settings)
+    {
+        juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32)blockSize, (juce::uint32)options.numChannels };
+
+        EQEngine engine;
+        engine.prepare(spec, makeChainCoefficients(settings, sampleRate), engineType);
+
+        // Filtering the same buffer in place over and over would boost it to inf or decay it
+        // to denormals, so every block starts again from the same noise
+        juce::AudioBuffer<float> input(options.numChannels, blockSize);
+        juce::AudioBuffer<float> buffer(options.numChannels, blockSize);
+        juce::Random random(0x70ce);
+
+        for (int channel = 0; channel < options.numChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                input.setSample(channel, i, random.nextFloat() * 2.f - 1.f);
+
+        auto restoreInput = [&]
+        {
+            for (int channel = 0; channel < options.numChannels; ++channel)
+                juce::FloatVectorOperations::copy(buffer.getWritePointer(channel), input.getReadPointer(channel), blockSize);
+        };
+
+        // the retargeting design is made up front, so only the audio path is timed
+        auto moved = settings;
+        moved.peakFreq *= 2.f;
+        const ChainCoefficients targets[] = { makeChainCoefficients(settings, sampleRate),
+                                              makeChainCoefficients(moved, sampleRate) };
+
+        juce::dsp::AudioBlock<float> block(buffer);
+        const auto numBlocks = juce::jmax(1, options.samplesPerRun / blockSize);
+
+        // warm up caches and branch predictors
+        for (int b = 0; b < juce::jmin(numBlocks, 16); ++b)
+        {
+            restoreInput();
+            engine.process(block, engineType, options.controlRate);
+        }
+
+        // the copies are timed on their own and taken off, leaving only the filtering
+        const auto copyStart = std::chrono::steady_clock::now();
+
+        for (int b = 0; b < numBlocks; ++b)
+            restoreInput();
+
+        const auto copyElapsed = std::chrono::steady_clock::now() - copyStart;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        {
+            // what processBlock may do, enforced in builds with TOKYOEQ_REALTIME_CHECKS
+            ScopedRealtimeSection realtimeSection;
+
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                if (options.automate)
+                    engine.setTarget(targets[b & 1]);
+
+                restoreInput();
+                engine.process(block, engineType, options.controlRate);
+            }
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start - copyElapsed;
+        const auto nanoseconds = juce::jmax(0.0, (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+        return nanoseconds / ((double)numBlocks * blockSize * options.numChannels);
+    }
+
+    // nanoseconds per transform, 'stereo' being the complex transform the analyzer runs for two channels
+    double runFFT(const BenchmarkOptions& options, FFTBackend& backend, bool stereo)
+    {
+        const auto fftSize = backend.getSize();
+
+        std::vector<float> input((size_t)fftSize * 2), data(input.size());
+        std::vector<juce::dsp::Complex<float>> complexInput((size_t)fftSize), complexOutput((size_t)fftSize);
+        juce::Random random(0x70ce);
+
+        for (int i = 0; i < fftSize; ++i)
+        {
+            input[(size_t)i] = random.nextFloat() * 2.f - 1.f;
+            complexInput[(size_t)i] = { input[(size_t)i], random.nextFloat() * 2.f - 1.f };
+        }
+
+        const auto numTransforms = juce::jmax(16, options.samplesPerRun / fftSize);
+
+        auto runOnce = [&]
+        {
+            if (stereo)
+            {
+                backend.perform(complexInput.data(), complexOutput.data());
+            }
+            else
+            {
+                std::copy(input.begin(), input.end(), data.begin());
+                backend.performFrequencyOnlyForwardTransform(data.data());
+            }
+        };
+
+        for (int t = 0; t < 16; ++t)
+            runOnce();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int t = 0; t < numTransforms; ++t)
+            runOnce();
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / numTransforms;
+    }
+
+    void benchmarkFFT(const BenchmarkOptions& options)
+    {
+        std::cout << "backend,order,transform,nsPerTransform,transformsPerSecond\n";
+
+        for (auto order : { 11, 12, 13 })
+        {
+            for (auto stereo : { false, true })
+            {
+                std::pair<const char*, std::unique_ptr<FFTBackend>> backends[] = { { "juce", createJuceFFTBackend(order) },
+                                                                                  { "simd", createSIMDFFTBackend(order) } };
+
+                for (auto& backend : backends)
+                {
+                    auto ns = runFFT(options, *backend.second, stereo);
+
+                    std::cout << backend.first << ','
+                              << order << ','
+                              << (stereo ? "stereo" : "mono") << ','
+                              << ns << ','
+                              << 1.0e9 / ns << '\n';
+                }
+            }
+        }
+    }
+
+    // the per-bin loops magnitudesToDecibels replaced, kept as the reference
+    void referenceMagnitudesToDecibels(float* data, int numBins, float negativeInfinity)
+    {
+        for (int i = 0; i < numBins; ++i)
+        {
+            auto v = data[i];
+
+            if (!std::isinf(v) && !std::isnan(v))
+                v /= float(numBins);
+            else
+                v = 0.f;
+
+            data[i] = v;
+        }
+
+        for (int i = 0; i < numBins; ++i)
+            data[i] = juce::Decibels::gainToDecibels(data[i], negativeInfinity);
+    }
+
+    void benchmarkSpectrum(const BenchmarkOptions& options)
+    {
+        const auto negativeInfinity = -48.f;
+
+        std::cout << "kernel,numBins,nsPerBin,maxErrorDecibels\n";
+
+        for (auto order : { 11, 12, 13 })
+        {
+            const auto numBins = 1 << (order - 1);
+
+            // magnitudes as an FFT of a full scale signal would give them, spanning the whole display range
+            std::vector<float> magnitudes((size_t)numBins), reference(magnitudes.size()), fused(magnitudes.size());
+            juce::Random random(0x70ce);
+
+            for (auto& m : magnitudes)
+                m = (float)numBins * std::pow(10.f, random.nextFloat() * -4.f);
+
+            reference = magnitudes;
+            referenceMagnitudesToDecibels(reference.data(), numBins, negativeInfinity);
+            magnitudesToDecibels(magnitudes.data(), fused.data(), numBins, 1.f / float(numBins), negativeInfinity);
+
+            auto maxError = 0.f;
+
+            for (int i = 0; i < numBins; ++i)
+                maxError = juce::jmax(maxError, std::abs(reference[(size_t)i] - fused[(size_t)i]));
+
+            const auto numRuns = juce::jmax(16, options.samplesPerRun / numBins);
+
+            auto time = [&](auto&& kernel)
+            {
+                const auto start = std::chrono::steady_clock::now();
+
+                for (int r = 0; r < numRuns; ++r)
+                    kernel();
+
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / ((double)numRuns * numBins);
+            };
+
+            auto referenceNs = time([&] { std::copy(magnitudes.begin(), magnitudes.end(), reference.begin());
+                                          referenceMagnitudesToDecibels(reference.data(), numBins, negativeInfinity); });
+
+            auto fusedNs = time([&] { magnitudesToDecibels(magnitudes.data(), fused.data(), numBins,
+                                                           1.f / float(numBins), negativeInfinity); });
+
+            std::cout << "reference," << numBins << ',' << referenceNs << ",0\n"
+                      << "fused," << numBins << ',' << fusedNs << ',' << maxError << '\n';
+        }
+    }
+
+    // the per-pixel, per-section getMagnitudeForFrequency loop ResponseCurveEvaluator replaced
+    void referenceResponse(const ChainCoefficients& coefficients, int width, double sampleRate, std::vector<float>& decibels)
+    {
+        juce::Array<juce::dsp::IIR::Coefficients<float>::Ptr> sections;
+
+        auto add = [&sections](const BiquadCoefficients& c)
+        {
+            sections.add(new juce::dsp::IIR::Coefficients<float>(c.b0, c.b1, c.b2, 1.f, c.a1, c.a2));
+        };
+
+        const auto& settings = coefficients.settings;
+
+        if (!settings.lowCutBypassed)
+            for (int i = 0; i <= (int)settings.lowCutSlope; ++i)
+                add(coefficients.lowCut[(size_t)i]);
+
+        if (!settings.peakBypassed)
+            add(coefficients.peak);
+
+        if (!settings.highCutBypassed)
+            for (int i = 0; i <= (int)settings.highCutSlope; ++i)
+                add(coefficients.highCut[(size_t)i]);
+
+        for (int i = 0; i < width; ++i)
+        {
+            double mag = 1.0;
+            auto freq = juce::mapToLog10(double(i) / double(width), 20.0, 20000.0);
+
+            for (auto& section : sections)
+                mag *= section->getMagnitudeForFrequency(freq, sampleRate);
+
+            decibels[(size_t)i] = juce::Decibels::gainToDecibels((float)mag);
+        }
+    }
+
+    void benchmarkResponse(const BenchmarkOptions& options)
+    {
+        std::cout << "method,width,sampleRate,usPerCurve,maxErrorDecibels\n";
+
+        for (auto sampleRate : { 48000.0, 192000.0 })
+        {
+            // every section active, the worst case while dragging
+            auto coefficients = makeChainCoefficients(makeSettings(Slope_48, 0), sampleRate);
+
+            for (auto width : { 1000, 1920, 3840, 7680 })
+            {
+                std::vector<float> reference((size_t)width), batch((size_t)width);
+
+                ResponseCurveEvaluator evaluator;
+                evaluator.prepare(width, sampleRate);
+
+                referenceResponse(coefficients, width, sampleRate, reference);
+                evaluator.evaluate(coefficients, batch.data());
+
+                // below the display's range the two floor differently
+                auto maxError = 0.f;
+
+                for (int i = 0; i < width; ++i)
+                    if (reference[(size_t)i] > -60.f)
+                        maxError = juce::jmax(maxError, std::abs(reference[(size_t)i] - batch[(size_t)i]));
+
+                const auto numRuns = juce::jmax(4, options.samplesPerRun / width);
+
+                auto time = [&](auto&& curve)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+
+                    for (int r = 0; r < numRuns; ++r)
+                        curve();
+
+                    const auto elapsed = std::chrono::steady_clock::now() - start;
+                    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (1000.0 * numRuns);
+                };
+
+                auto referenceUs = time([&] { referenceResponse(coefficients, width, sampleRate, reference); });
+                auto batchUs = time([&] { evaluator.evaluate(coefficients, batch.data()); });
+
+                std::cout << "reference," << width << ',' << sampleRate << ',' << referenceUs << ",0\n"
+                          << "batch," << width << ',' << sampleRate << ',' << batchUs << ',' << maxError << '\n';
+            }
+        }
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: TokyoEQBenchmark [--engine scalar|simd|fused|svf] [--channels N]\n"
+                     "                        [--samples N] [--control-rate N] [--automate]\n"
+                     "       TokyoEQBenchmark --fft [--samples N]\n"
+                     "       TokyoEQBenchmark --spectrum [--samples N]\n"
+                     "       TokyoEQBenchmark --response [--samples N]\n";
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    // processBlock runs like this too
+    juce::ScopedNoDenormals noDenormals;
+
+    BenchmarkOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg(argv[i]);
+        juce::String value(i + 1 < argc ? argv[i + 1] : "");
+
+        if (arg == "--engine")
+        {
+            options.engines.clear();
+
+            for (auto engine : { EQEngine::ScalarBiquad, EQEngine::SIMDChannels, EQEngine::FusedCascade, EQEngine::StateVariable })
+                if (value == getEngineName(engine))
+                    options.engines.add(engine);
+
+            ++i;
+        }
+        else if (arg == "--channels")        { options.numChannels = juce::jmax(1, value.getIntValue()); ++i; }
+        else if (arg == "--samples")         { options.samplesPerRun = juce::jmax(1, value.getIntValue()); ++i; }
+        else if (arg == "--control-rate")    { options.controlRate = juce::jmax(1, value.getIntValue()); ++i; }
+        else if (arg == "--automate")        { options.automate = true; }
+        else if (arg == "--fft")             { options.fft = true; }
+        else if (arg == "--spectrum")        { options.spectrum = true; }
+        else if (arg == "--response")        { options.response = true; }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (options.fft)
+    {
+        benchmarkFFT(options);
+        return 0;
+    }
+
+    if (options.spectrum)
+    {
+        benchmarkSpectrum(options);
+        return 0;
+    }
+
+    if (options.response)
+    {
+        benchmarkResponse(options);
+        return 0;
+    }
+
+    if (options.engines.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    const double sampleRates[] = { 44100.0, 48000.0, 96000.0, 192000.0, 384000.0 };
+    const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    const Slope slopes[] = { Slope_12, Slope_24, Slope_36, Slope_48 };
+
+    // bypass mask: 1 = LowCut, 2 = Peak, 4 = HighCut
+    std::cout << "engine,sampleRate,blockSize,slope,bypassMask,nsPerSample,samplesPerSecond\n";
+
+    for (auto engine : options.engines)
+        for (auto sampleRate : sampleRates)
+            for (auto blockSize : blockSizes)
+                for (auto slope : slopes)
+                    for (int bypassMask = 0; bypassMask < 8; ++bypassMask)
+                    {
+                        auto ns = runOne(options, engine, sampleRate, blockSize, makeSettings(slope, bypassMask));
+
+                        std::cout << getEngineName(engine) << ','
+                                  << sampleRate << ','
+                                  << blockSize << ','
+                                  << 12 * (slope + 1) << ','
+                                  << bypassMask << ','
+                                  << ns << ','
+                                  << 1.0e9 / ns << '\n';
+                    }
+
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+  ==============================================================================
+    Fused second order sections kernel for the whole LowCut / Peak / HighCut
+    chain.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <type_traits>
+
+#include "FilterDesign.h"
+
+/**
+ Runs every active biquad of a ChainCoefficients design in one pass over the
+ block. Bypassed bands and the stages a slope doesn't use are left out when the
+ coefficients are set, so the per-sample loop only ever sees the sections
+ that do work. Sections use transposed direct form II, like
+ juce::dsp::IIR::Filter, and the state lives in locals for the whole block.
+
+ The slopes and bypass states only decide how many sections are packed, so
+ there is one specialisation per section count, dispatched when the
+ coefficients change.
+
+ SampleType is float for one channel or juce::dsp::SIMDRegister<float> to
+ filter several channels in parallel, one per lane. The lanes normally share
+ one design, but each can also be given its own (see BatchEQEngine); a lane
+ with fewer active sections is padded with pass-through sections.
+ */
+template<typename SampleType>
+struct BiquadCascade
+{
+    // four low cut stages, the peak and four high cut stages
+    static constexpr int maxSections = 9;
+
+    // 1 for float, 4 for an SSE/NEON SIMDRegister<float>...
+    static constexpr size_t numLanes = sizeof(SampleType) / sizeof(float);
+
+    // the same design in every lane
+    void setCoefficients(const ChainCoefficients& chainCoefficients)
+    {
+        // packSections only writes the active slots, and relocateState compares all of them
+        LaneSlots newSlots;
+        newSlots.fill(paddingSlot);
+
+        LaneBiquads biquads;
+        auto newNumSections = packSections(chainCoefficients, newSlots, biquads);
+
+        for (int n = 0; n < newNumSections; ++n)
+        {
+            auto& section = sections[(size_t)n];
+            const auto& biquad = *biquads[(size_t)n];
+
+            section.b0 = broadcast(biquad.b0);
+            section.b1 = broadcast(biquad.b1);
+            section.b2 = broadcast(biquad.b2);
+            section.a1 = broadcast(biquad.a1);
+            section.a2 = broadcast(biquad.a2);
+        }
+
+        std::array<LaneSlots, numLanes> newLaneSlots;
+        newLaneSlots.fill(newSlots);
+
+        relocateState(newLaneSlots, newNumSections);
+    }
+
+    // a separate design per lane
+    void setCoefficients(const std::array<ChainCoefficients, numLanes>& laneCoefficients)
+    {
+        std::array<LaneSlots, numLanes> newLaneSlots;
+        std::array<LaneBiquads, numLanes> laneBiquads;
+        std::array<int, numLanes> laneNumSections;
+        int newNumSections = 0;
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            newLaneSlots[lane].fill(paddingSlot);
+            laneNumSections[lane] = packSections(laneCoefficients[lane], newLaneSlots[lane], laneBiquads[lane]);
+            newNumSections = juce::jmax(newNumSections, laneNumSections[lane]);
+        }
+
+        const BiquadCoefficients passThrough;
+
+        for (int n = 0; n < newNumSections; ++n)
+        {
+            auto& section = sections[(size_t)n];
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                const auto isPadding = n >= laneNumSections[lane];
+                const auto& biquad = isPadding ? passThrough : *laneBiquads[lane][(size_t)n];
+
+                setLane(section.b0, lane, biquad.b0);
+                setLane(section.b1, lane, biquad.b1);
+                setLane(section.b2, lane, biquad.b2);
+                setLane(section.a1, lane, biquad.a1);
+                setLane(section.a2, lane, biquad.a2);
+            }
+        }
+
+        relocateState(newLaneSlots, newNumSections);
+    }
+
+    void reset()
+    {
+        z1.fill(SampleType());
+        z2.fill(SampleType());
+    }
+
+    int getNumActiveSections() const { return numSections; }
+
+    //==============================================================================
+    void process(SampleType* samples, int numSamples) noexcept
+    {
+        (this->*processFunction)(samples, numSamples);
+    }
+
+private:
+    static constexpr int lowCutSlot = 0;
+    static constexpr int peakSlot = 4;
+    static constexpr int highCutSlot = 5;
+    static constexpr int paddingSlot = -1;
+
+    // which slot (lowCutSlot + stage, peakSlot...) each packed section came from
+    using LaneSlots = std::array<int, maxSections>;
+    using LaneBiquads = std::array<const BiquadCoefficients*, maxSections>;
+
+    static int packSections(const ChainCoefficients& chainCoefficients, LaneSlots& slotsOut, LaneBiquads& biquadsOut)
+    {
+        const auto& chainSettings = chainCoefficients.settings;
+        int count = 0;
+
+        auto add = [&slotsOut, &biquadsOut, &count](int slot, const BiquadCoefficients& biquad)
+        {
+            slotsOut[(size_t)count] = slot;
+            biquadsOut[(size_t)count] = &biquad;
+            ++count;
+        };
+
+        if (!chainSettings.lowCutBypassed)
+            for (int stage = 0; stage <= chainSettings.lowCutSlope; ++stage)
+                add(lowCutSlot + stage, chainCoefficients.lowCut[(size_t)stage]);
+
+        if (!chainSettings.peakBypassed)
+            add(peakSlot, chainCoefficients.peak);
+
+        if (!chainSettings.highCutBypassed)
+            for (int stage = 0; stage <= chainSettings.highCutSlope; ++stage)
+                add(highCutSlot + stage, chainCoefficients.highCut[(size_t)stage]);
+
+        return count;
+    }
+
+    struct Section
+    {
+        SampleType b0, b1, b2, a1, a2;
+    };
+
+    using ProcessFunction = void (BiquadCascade::*)(SampleType*, int) noexcept;
+
+    /*
+     The section count is a template argument here, so the inner loop has a
+     fixed trip count: no per-stage bypass tests, and the compiler can unroll
+     it and keep every state in a register for the whole block.
+     */
+    template<int NumSections>
+    void processSections(SampleType* samples, int numSamples) noexcept
+    {
+        if constexpr (NumSections > 0)
+        {
+            std::array<SampleType, NumSections> s1, s2;
+
+            for (size_t n = 0; n < NumSections; ++n)
+            {
+                s1[n] = z1[n];
+                s2[n] = z2[n];
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto x = samples[i];
+
+                for (size_t n = 0; n < NumSections; ++n)
+                {
+                    const auto& section = sections[n];
+
+                    auto y = section.b0 * x + s1[n];
+                    s1[n] = section.b1 * x - section.a1 * y + s2[n];
+                    s2[n] = section.b2 * x - section.a2 * y;
+                    x = y;
+                }
+
+                samples[i] = x;
+            }
+
+            for (size_t n = 0; n < NumSections; ++n)
+            {
+                juce::dsp::util::snapToZero(s1[n]);
+                juce::dsp::util::snapToZero(s2[n]);
+
+                z1[n] = s1[n];
+                z2[n] = s2[n];
+            }
+        }
+        else
+        {
+            juce::ignoreUnused(samples, numSamples);
+        }
+    }
+
+    // picked once when the slopes or bypass states change, not per block
+    static ProcessFunction getProcessFunction(int numSections)
+    {
+        switch (numSections)
+        {
+        case 1: return &BiquadCascade::processSections<1>;
+        case 2: return &BiquadCascade::processSections<2>;
+        case 3: return &BiquadCascade::processSections<3>;
+        case 4: return &BiquadCascade::processSections<4>;
+        case 5: return &BiquadCascade::processSections<5>;
+        case 6: return &BiquadCascade::processSections<6>;
+        case 7: return &BiquadCascade::processSections<7>;
+        case 8: return &BiquadCascade::processSections<8>;
+        case 9: return &BiquadCascade::processSections<9>;
+        default: break;
+        }
+
+        return &BiquadCascade::processSections<0>;
+    }
+
+    static SampleType broadcast(float value)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return value;
+        else
+            return SampleType::expand(value);
+    }
+
+    static float getLane(const SampleType& value, size_t lane)
+    {
+        juce::ignoreUnused(lane);
+
+        if constexpr (std::is_same_v<SampleType, float>)
+            return value;
+        else
+            return value.get(lane);
+    }
+
+    static void setLane(SampleType& value, size_t lane, float newValue)
+    {
+        juce::ignoreUnused(lane);
+
+        if constexpr (std::is_same_v<SampleType, float>)
+            value = newValue;
+        else
+            value.set(lane, newValue);
+    }
+
+    /*
+     Sections are packed, so a slope or bypass change moves a stage to a new
+     index. Each lane's running states follow their slot to the new index, so
+     unchanged stages carry on without a click and stages that just switched
+     on start from silence. Nothing moves if the layout didn't change, which
+     is the usual case while a frequency ramps.
+     */
+    void relocateState(const std::array<LaneSlots, numLanes>& newLaneSlots, int newNumSections)
+    {
+        if (newNumSections != numSections || newLaneSlots != laneSlots)
+        {
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                std::array<float, maxSections> parkedZ1{}, parkedZ2{};
+                std::array<bool, maxSections> wasActive{};
+
+                for (int n = 0; n < numSections; ++n)
+                {
+                    auto slot = laneSlots[lane][(size_t)n];
+
+                    if (slot != paddingSlot)
+                    {
+                        parkedZ1[(size_t)slot] = getLane(z1[(size_t)n], lane);
+                        parkedZ2[(size_t)slot] = getLane(z2[(size_t)n], lane);
+                        wasActive[(size_t)slot] = true;
+                    }
+                }
+
+                for (int n = 0; n < newNumSections; ++n)
+                {
+                    auto slot = newLaneSlots[lane][(size_t)n];
+                    auto keep = slot != paddingSlot && wasActive[(size_t)slot];
+
+                    setLane(z1[(size_t)n], lane, keep ? parkedZ1[(size_t)slot] : 0.f);
+                    setLane(z2[(size_t)n], lane, keep ? parkedZ2[(size_t)slot] : 0.f);
+                }
+            }
+        }
+
+        laneSlots = newLaneSlots;
+        numSections = newNumSections;
+        processFunction = getProcessFunction(numSections);
+    }
+
+    std::array<Section, maxSections> sections;
+    std::array<LaneSlots, numLanes> laneSlots{};
+    int numSections = 0;
+    ProcessFunction processFunction = &BiquadCascade::processSections<0>;
+
+    std::array<SampleType, maxSections> z1{}, z2{};
+};
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+    Ramps the continuous ChainSettings values towards the latest published
+    design and redesigns the moving bands at control rate.
+  ==============================================================================
+*/
+
+#include "ChainSmoother.h"
+
+void ChainSmoother::prepare(double newSampleRate, const ChainCoefficients& initial)
+{
+    sampleRate = newSampleRate;
+    target = initial;
+    current = initial;
+
+    const auto& settings = initial.settings;
+
+    lowCutFreq.reset(sampleRate, rampLengthSeconds);
+    highCutFreq.reset(sampleRate, rampLengthSeconds);
+    peakFreq.reset(sampleRate, rampLengthSeconds);
+    peakQuality.reset(sampleRate, rampLengthSeconds);
+    peakGain.reset(sampleRate, rampLengthSeconds);
+
+    lowCutFreq.setCurrentAndTargetValue(settings.lowCutFreq);
+    highCutFreq.setCurrentAndTargetValue(settings.highCutFreq);
+    peakFreq.setCurrentAndTargetValue(settings.peakFreq);
+    peakQuality.setCurrentAndTargetValue(settings.peakQuality);
+    peakGain.setCurrentAndTargetValue(settings.peakGainInDecibels);
+}
+
+void ChainSmoother::setTarget(const ChainCoefficients& newTarget)
+{
+    target = newTarget;
+
+    const auto& settings = target.settings;
+
+    lowCutFreq.setTargetValue(settings.lowCutFreq);
+    highCutFreq.setTargetValue(settings.highCutFreq);
+    peakFreq.setTargetValue(settings.peakFreq);
+    peakQuality.setTargetValue(settings.peakQuality);
+    peakGain.setTargetValue(settings.peakGainInDecibels);
+}
+
+bool ChainSmoother::isSmoothing() const
+{
+    return lowCutFreq.isSmoothing()
+        || highCutFreq.isSmoothing()
+        || peakFreq.isSmoothing()
+        || peakQuality.isSmoothing()
+        || peakGain.isSmoothing();
+}
+
+const ChainCoefficients& ChainSmoother::advance(int numSamples, bool redesignBiquads)
+{
+    auto lowCutMoving = redesignBiquads && lowCutFreq.isSmoothing();
+    auto highCutMoving = redesignBiquads && highCutFreq.isSmoothing();
+    auto peakMoving = redesignBiquads && (peakFreq.isSmoothing() || peakQuality.isSmoothing() || peakGain.isSmoothing());
+
+    auto& settings = current.settings;
+    settings = target.settings;
+
+    settings.lowCutFreq = lowCutFreq.skip(numSamples);
+    settings.highCutFreq = highCutFreq.skip(numSamples);
+    settings.peakFreq = peakFreq.skip(numSamples);
+    settings.peakQuality = peakQuality.skip(numSamples);
+    settings.peakGainInDecibels = peakGain.skip(numSamples);
+
+    current.lowCut = lowCutMoving ? designLowCutCoefficients(settings, sampleRate) : target.lowCut;
+    current.peak = peakMoving ? designPeakCoefficients(settings, sampleRate) : target.peak;
+    current.highCut = highCutMoving ? designHighCutCoefficients(settings, sampleRate) : target.highCut;
+
+    return current;
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+    Ramps the continuous ChainSettings values towards the latest published
+    design and redesigns the moving bands at control rate.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "FilterDesign.h"
+
+/**
+ Frequencies and Q ramp multiplicatively, the peak gain linearly in dB.
+ Slopes and bypass states are discrete and switch straight away. Bands that
+ aren't moving reuse the target's coefficients, so a steady session never
+ designs anything on the audio thread.
+ */
+struct ChainSmoother
+{
+    void prepare(double sampleRate, const ChainCoefficients& initial);
+
+    // Audio thread: a new design was published, start ramping towards it
+    void setTarget(const ChainCoefficients& newTarget);
+
+    bool isSmoothing() const;
+
+    /** Moves every ramp on by numSamples and returns the design for that
+        point. Only the moving bands are redesigned, and none at all if the
+        caller only needs the settings (engines that design their own). */
+    const ChainCoefficients& advance(int numSamples, bool redesignBiquads = true);
+
+    const ChainCoefficients& getTarget() const { return target; }
+
+private:
+    using FrequencySmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+    using GainSmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear>;
+
+    static constexpr double rampLengthSeconds = 0.05;
+
+    double sampleRate = 0.0;
+
+    FrequencySmoother lowCutFreq, highCutFreq, peakFreq, peakQuality;
+    GainSmoother peakGain;
+
+    ChainCoefficients target, current;
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+    Background thread that turns parameter changes into ChainCoefficients and
+    hands them to the audio thread through a TripleBuffer.
+  ==============================================================================
+*/
+
+#include "CoefficientDesigner.h"
+
+CoefficientDesigner::CoefficientDesigner(juce::AudioProcessorValueTreeState& state) :
+    juce::Thread("TokyoEQ Coefficient Designer"),
+    apvts(state)
+{
+}
+
+CoefficientDesigner::~CoefficientDesigner()
+{
+    release();
+}
+
+void CoefficientDesigner::prepare(double newSampleRate)
+{
+    release();
+
+    sampleRate.set(newSampleRate);
+    markAllBandsChanged();
+
+    // the audio thread isn't running yet, so have a full design ready for the first block
+    designChangedBands();
+
+    startThread();
+}
+
+void CoefficientDesigner::release()
+{
+    // stopThread's notify() doesn't reach a thread sleeping on the signal
+    signalThreadShouldExit();
+    wakeSignal.signal();
+    stopThread(1000);
+}
+
+void CoefficientDesigner::markBandChanged(ChainPositions band)
+{
+    bandChanged[(size_t)band].set(true);
+    wakeSignal.signal();
+}
+
+void CoefficientDesigner::markAllBandsChanged()
+{
+    for (auto& changed : bandChanged)
+        changed.set(true);
+
+    wakeSignal.signal();
+}
+
+void CoefficientDesigner::run()
+{
+    while (!threadShouldExit())
+    {
+        designChangedBands();
+
+        // sleeps until a band changes, however long that takes
+        wakeSignal.wait(-1);
+    }
+}
+
+void CoefficientDesigner::designChangedBands()
+{
+    const juce::ScopedLock sl(designLock);
+
+    auto lowCutChanged  = bandChanged[ChainPositions::LowCut].compareAndSetBool(false, true);
+    auto peakChanged    = bandChanged[ChainPositions::Peak].compareAndSetBool(false, true);
+    auto highCutChanged = bandChanged[ChainPositions::HighCut].compareAndSetBool(false, true);
+
+    if (!lowCutChanged && !peakChanged && !highCutChanged)
+        return;
+
+    auto rate = sampleRate.get();
+    if (rate <= 0.0)
+        return;
+
+    // flags were cleared before reading, so a change arriving now is designed next time round.
+    // Only the designed bands take their new settings, keeping slopes in step with coefficients.
+    auto settings = getChainSettings(apvts);
+
+    if (lowCutChanged)
+    {
+        current.lowCut = designLowCutCoefficients(settings, rate);
+        current.settings.lowCutFreq = settings.lowCutFreq;
+        current.settings.lowCutSlope = settings.lowCutSlope;
+        current.settings.lowCutBypassed = settings.lowCutBypassed;
+    }
+
+    if (peakChanged)
+    {
+        current.peak = designPeakCoefficients(settings, rate);
+        current.settings.peakFreq = settings.peakFreq;
+        current.settings.peakGainInDecibels = settings.peakGainInDecibels;
+        current.settings.peakQuality = settings.peakQuality;
+        current.settings.peakBypassed = settings.peakBypassed;
+    }
+
+    if (highCutChanged)
+    {
+        current.highCut = designHighCutCoefficients(settings, rate);
+        current.settings.highCutFreq = settings.highCutFreq;
+        current.settings.highCutSlope = settings.highCutSlope;
+        current.settings.highCutBypassed = settings.highCutBypassed;
+    }
+
+    published.getWriteBuffer() = current;
+    published.publish();
+}
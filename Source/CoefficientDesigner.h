@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+    Background thread that turns parameter changes into ChainCoefficients and
+    hands them to the audio thread through a TripleBuffer.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "FilterDesign.h"
+#include "RealtimeSignal.h"
+#include "TripleBuffer.h"
+
+class CoefficientDesigner : juce::Thread
+{
+public:
+    CoefficientDesigner(juce::AudioProcessorValueTreeState& apvts);
+    ~CoefficientDesigner() override;
+
+    /** Designs every band for the new sample rate on the calling thread and
+        starts the background thread. Call from prepareToPlay. */
+    void prepare(double sampleRate);
+    void release();
+
+    //==============================================================================
+    // Realtime safe, hosts call parameter listeners on the audio thread
+    void markBandChanged(ChainPositions band);
+    void markAllBandsChanged();
+
+    //==============================================================================
+    // Audio thread only: picks up the latest published design, never blocks
+    bool pullCoefficients() { return published.pull(); }
+    const ChainCoefficients& getCoefficients() const { return published.getReadBuffer(); }
+
+private:
+    void run() override;
+    void designChangedBands();
+
+    juce::AudioProcessorValueTreeState& apvts;
+    juce::Atomic<double> sampleRate{ 0.0 };
+
+    std::array<juce::Atomic<bool>, 3> bandChanged;
+
+    // only touched while holding designLock
+    juce::CriticalSection designLock;
+    ChainCoefficients current;
+
+    TripleBuffer<ChainCoefficients> published;
+
+    // notify() locks, so the listeners wake the thread through this instead
+    RealtimeSignal wakeSignal;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoefficientDesigner)
+};
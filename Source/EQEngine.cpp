@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+    The filter path of the plugin: smoothing plus the selectable processing
+    engines, with no dependency on the plugin wrapper or the editor.
+  ==============================================================================
+*/
+
+#include "EQEngine.h"
+
+void EQEngine::prepare(const juce::dsp::ProcessSpec& spec, const ChainCoefficients& initial, ProcessingEngine engine)
+{
+    sampleRate = spec.sampleRate;
+
+    const auto numChannels = (size_t)spec.numChannels;
+
+    chains.resize(numChannels);
+    for (auto& chain : chains)
+    {
+        if (chain == nullptr)
+            chain = std::make_unique<MonoChain>();
+
+        prepareChainCoefficients(*chain);
+    }
+
+    cascades.resize(numChannels);
+    svfCascades.resize(numChannels);
+
+    simdEngine.prepare(spec);
+
+    activeEngine = engine;
+
+    chainSmoother.prepare(sampleRate, initial);
+    updateFilters(initial);
+
+    auto monoSpec = spec;
+    monoSpec.numChannels = 1;
+
+    for (auto& chain : chains)
+        chain->prepare(monoSpec);
+
+    reset();
+}
+
+void EQEngine::setTarget(const ChainCoefficients& chainCoefficients)
+{
+    chainSmoother.setTarget(chainCoefficients);
+
+    if (!chainSmoother.isSmoothing())
+        updateFilters(chainSmoother.getTarget());
+}
+
+void EQEngine::process(juce::dsp::AudioBlock<float>& block, ProcessingEngine requestedEngine, int controlRate)
+{
+    selectEngine(block, requestedEngine);
+
+    if (chainSmoother.isSmoothing())
+    {
+        // redesign at control rate rather than per host block, whatever size that is
+        const auto numSamples = block.getNumSamples();
+        const auto subBlockSize = (size_t)juce::jmax(1, controlRate);
+
+        for (size_t start = 0; start < numSamples; start += subBlockSize)
+        {
+            auto length = juce::jmin(subBlockSize, numSamples - start);
+
+            // the SVF engine designs its own sections from the settings
+            auto redesignBiquads = activeEngine != ProcessingEngine::StateVariable;
+            updateFilters(chainSmoother.advance((int)length, redesignBiquads));
+
+            auto subBlock = block.getSubBlock(start, length);
+            processFilters(subBlock);
+        }
+    }
+    else
+    {
+        processFilters(block);
+    }
+}
+
+void EQEngine::updateFilters(const ChainCoefficients& chainCoefficients)
+{
+    appliedCoefficients = chainCoefficients;
+
+    // only the engine that's running needs them, selectEngine() catches the others up
+    switch (activeEngine)
+    {
+    case ProcessingEngine::SIMDChannels:
+        simdEngine.updateCoefficients(chainCoefficients);
+        break;
+    case ProcessingEngine::FusedCascade:
+        for (auto& cascade : cascades)
+            cascade.setCoefficients(chainCoefficients);
+        break;
+    case ProcessingEngine::StateVariable:
+        for (auto& cascade : svfCascades)
+            cascade.setCoefficients(chainCoefficients.settings, sampleRate);
+        break;
+    case ProcessingEngine::ScalarBiquad:
+    default:
+        for (auto& chain : chains)
+            updateChainCoefficients(*chain, chainCoefficients);
+        break;
+    }
+}
+
+void EQEngine::selectEngine(const juce::dsp::AudioBlock<float>& block, ProcessingEngine requestedEngine)
+{
+    auto engine = requestedEngine;
+    if (engine == ProcessingEngine::SIMDChannels && !simdEngine.canProcess(block))
+        engine = ProcessingEngine::FusedCascade;
+
+    if (engine == activeEngine)
+        return;
+
+    // the other engine's state is stale by now, start it from silence
+    reset();
+
+    activeEngine = engine;
+    updateFilters(appliedCoefficients);
+}
+
+void EQEngine::reset()
+{
+    for (auto& chain : chains)
+        chain->reset();
+
+    simdEngine.reset();
+
+    for (auto& cascade : cascades)
+        cascade.reset();
+
+    for (auto& cascade : svfCascades)
+        cascade.reset();
+}
+
+void EQEngine::processFilters(juce::dsp::AudioBlock<float>& block)
+{
+    // never touch more channels than prepare() made state for
+    const auto numChannels = juce::jmin(block.getNumChannels(), cascades.size());
+    const auto numSamples = (int)block.getNumSamples();
+
+    switch (activeEngine)
+    {
+    case ProcessingEngine::SIMDChannels:
+        simdEngine.process(block);
+        break;
+    case ProcessingEngine::FusedCascade:
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            cascades[channel].process(block.getChannelPointer(channel), numSamples);
+        break;
+    case ProcessingEngine::StateVariable:
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            svfCascades[channel].process(block.getChannelPointer(channel), numSamples);
+        break;
+    case ProcessingEngine::ScalarBiquad:
+    default:
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto channelBlock = block.getSingleChannelBlock(channel);
+            juce::dsp::ProcessContextReplacing<float> context(channelBlock);
+
+            chains[channel]->process(context);
+        }
+        break;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+    The filter path of the plugin: smoothing plus the selectable processing
+    engines, with no dependency on the plugin wrapper or the editor.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <memory>
+#include <vector>
+
+#include "FilterDesign.h"
+#include "FilterChain.h"
+#include "BiquadCascade.h"
+#include "SVFCascade.h"
+#include "MultiChannelBiquadEngine.h"
+#include "ChainSmoother.h"
+
+/**
+ Everything processBlock does to the audio, so the plugin and headless tools
+ (the benchmark, batch renders) run exactly the same code. Designs come in
+ through setTarget(), from the CoefficientDesigner in the plugin or straight
+ from makeChainCoefficients() elsewhere.
+ */
+class EQEngine
+{
+public:
+    enum ProcessingEngine
+    {
+        ScalarBiquad,   // one juce::dsp::ProcessorChain per channel
+        SIMDChannels,   // channels side by side in SIMD registers, see MultiChannelBiquadEngine
+        FusedCascade,   // one BiquadCascade per channel, every section in a single pass
+        StateVariable   // one SVFCascade per channel, for heavily modulated sessions
+    };
+
+    // Sizes every engine for spec.numChannels and applies the initial design without a ramp
+    void prepare(const juce::dsp::ProcessSpec& spec, const ChainCoefficients& initial, ProcessingEngine engine);
+    void reset();
+
+    // A new design: continuous values ramp towards it, slopes and bypasses switch now
+    void setTarget(const ChainCoefficients& chainCoefficients);
+
+    /** Filters the block in place with the requested engine, switching to it
+        first if needed. While ramping, coefficients are redesigned every
+        controlRate samples whatever the block size. */
+    void process(juce::dsp::AudioBlock<float>& block, ProcessingEngine requestedEngine, int controlRate);
+
+    ProcessingEngine getActiveEngine() const { return activeEngine; }
+
+private:
+    // every engine keeps one state per channel, all sharing one design
+    std::vector<std::unique_ptr<MonoChain>> chains;
+    MultiChannelBiquadEngine simdEngine;
+    std::vector<BiquadCascade<float>> cascades;
+    std::vector<SVFCascade<float>> svfCascades;
+
+    ProcessingEngine activeEngine{ ProcessingEngine::FusedCascade };
+    double sampleRate = 44100.0;
+
+    ChainSmoother chainSmoother;
+
+    // what the active engine is running, handed to an engine when it takes over
+    ChainCoefficients appliedCoefficients;
+
+    //==============================================================================
+    void updateFilters(const ChainCoefficients& chainCoefficients);
+    void selectEngine(const juce::dsp::AudioBlock<float>& block, ProcessingEngine requestedEngine);
+    void processFilters(juce::dsp::AudioBlock<float>& block);
+
+    JUCE_LEAK_DETECTOR(EQEngine)
+};
@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+    Forward FFTs for the analyzer, with the implementation chosen at build
+    time.
+  ==============================================================================
+*/
+
+#include "FFTBackend.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    struct JuceFFTBackend : FFTBackend
+    {
+        explicit JuceFFTBackend(int fftOrder) : FFTBackend(fftOrder), fft(fftOrder) {}
+
+        void performFrequencyOnlyForwardTransform(float* data) noexcept override
+        {
+            fft.performFrequencyOnlyForwardTransform(data);
+        }
+
+        void perform(const juce::dsp::Complex<float>* input, juce::dsp::Complex<float>* output) noexcept override
+        {
+            fft.perform(input, output, false);
+        }
+
+        juce::dsp::FFT fft;
+    };
+
+    //==============================================================================
+#if JUCE_USE_SIMD
+    using Lanes = juce::dsp::SIMDRegister<float>;
+    constexpr int numLanes = (int)Lanes::SIMDNumElements;
+#else
+    using Lanes = float;
+    constexpr int numLanes = 1;
+#endif
+
+    // float storage aligned for Lanes loads and stores
+    struct AlignedFloats
+    {
+        explicit AlignedFloats(int size) : storage((size_t)((size + numLanes - 1) / numLanes)) {}
+
+        float* get() noexcept { return reinterpret_cast<float*>(storage.data()); }
+
+        std::vector<Lanes> storage;
+    };
+
+    /**
+     Radix-2 Stockham autosort FFT on split real / imaginary arrays. Every
+     stage streams from one pair of arrays into the other in natural order, so
+     there's no bit reversal pass. Once a stage's stride reaches the SIMD width,
+     its butterflies run a whole register at a time with the twiddle broadcast.
+     */
+    struct StockhamFFT
+    {
+        explicit StockhamFFT(int fftOrder) :
+            size(1 << fftOrder),
+            re(size), im(size), workRe(size), workIm(size)
+        {
+            // stage n (n = size, size / 2 ... 2) uses exp(-2 pi i p / n) for p < n / 2
+            for (int n = size; n >= 2; n >>= 1)
+            {
+                for (int p = 0; p < n / 2; ++p)
+                {
+                    auto angle = -juce::MathConstants<double>::twoPi * p / n;
+                    twiddleRe.push_back((float)std::cos(angle));
+                    twiddleIm.push_back((float)std::sin(angle));
+                }
+            }
+        }
+
+        // transforms getReal() / getImag() in place
+        void perform() noexcept
+        {
+            auto* xr = re.get();
+            auto* xi = im.get();
+            auto* yr = workRe.get();
+            auto* yi = workIm.get();
+
+            const auto* wr = twiddleRe.data();
+            const auto* wi = twiddleIm.data();
+
+            for (int n = size, s = 1; n >= 2; n >>= 1, s <<= 1)
+            {
+                const auto m = n / 2;
+
+                if (s >= numLanes)
+                    vectorStage(xr, xi, yr, yi, wr, wi, m, s);
+                else
+                    scalarStage(xr, xi, yr, yi, wr, wi, m, s);
+
+                wr += m;
+                wi += m;
+
+                std::swap(xr, yr);
+                std::swap(xi, yi);
+            }
+
+            if (xr != re.get())
+            {
+                juce::FloatVectorOperations::copy(re.get(), xr, size);
+                juce::FloatVectorOperations::copy(im.get(), xi, size);
+            }
+        }
+
+        float* getReal() noexcept { return re.get(); }
+        float* getImag() noexcept { return im.get(); }
+        int getSize() const noexcept { return size; }
+
+    private:
+        static void scalarStage(const float* xr, const float* xi, float* yr, float* yi,
+                                const float* wr, const float* wi, int m, int s) noexcept
+        {
+            for (int p = 0; p < m; ++p)
+            {
+                for (int q = 0; q < s; ++q)
+                {
+                    auto a = q + s * p;
+                    auto b = a + s * m;
+                    auto even = q + s * 2 * p;
+                    auto odd = even + s;
+
+                    auto dr = xr[a] - xr[b];
+                    auto di = xi[a] - xi[b];
+
+                    yr[even] = xr[a] + xr[b];
+                    yi[even] = xi[a] + xi[b];
+                    yr[odd] = dr * wr[p] - di * wi[p];
+                    yi[odd] = dr * wi[p] + di * wr[p];
+                }
+            }
+        }
+
+        static void vectorStage(const float* xr, const float* xi, float* yr, float* yi,
+                                const float* wr, const float* wi, int m, int s) noexcept
+        {
+#if JUCE_USE_SIMD
+            for (int p = 0; p < m; ++p)
+            {
+                const auto twr = Lanes::expand(wr[p]);
+                const auto twi = Lanes::expand(wi[p]);
+
+                for (int q = 0; q < s; q += numLanes)
+                {
+                    auto a = q + s * p;
+                    auto b = a + s * m;
+                    auto even = q + s * 2 * p;
+                    auto odd = even + s;
+
+                    auto ar = Lanes::fromRawArray(xr + a), ai = Lanes::fromRawArray(xi + a);
+                    auto br = Lanes::fromRawArray(xr + b), bi = Lanes::fromRawArray(xi + b);
+
+                    auto dr = ar - br;
+                    auto di = ai - bi;
+
+                    (ar + br).copyToRawArray(yr + even);
+                    (ai + bi).copyToRawArray(yi + even);
+                    (dr * twr - di * twi).copyToRawArray(yr + odd);
+                    (dr * twi + di * twr).copyToRawArray(yi + odd);
+                }
+            }
+#else
+            scalarStage(xr, xi, yr, yi, wr, wi, m, s);
+#endif
+        }
+
+        const int size;
+        AlignedFloats re, im, workRe, workIm;
+        std::vector<float> twiddleRe, twiddleIm;
+    };
+
+    //==============================================================================
+    struct SIMDFFTBackend : FFTBackend
+    {
+        /*
+         A real transform of size N runs as a complex one of size N / 2 on the
+         even and odd samples, z[n] = x[2n] + i x[2n + 1], then untangles it:
+             X[k] = E[k] + exp(-2 pi i k / N) O[k],
+             E[k] = (Z[k] + conj(Z[N/2 - k])) / 2,  O[k] = (Z[k] - conj(Z[N/2 - k])) / 2i
+         */
+        explicit SIMDFFTBackend(int fftOrder) :
+            FFTBackend(fftOrder),
+            fullFFT(fftOrder),
+            halfFFT(juce::jmax(0, fftOrder - 1))
+        {
+            const auto n = getSize();
+
+            for (int k = 0; k <= n / 2; ++k)
+            {
+                auto angle = -juce::MathConstants<double>::twoPi * k / n;
+                untangleRe.push_back((float)std::cos(angle));
+                untangleIm.push_back((float)std::sin(angle));
+            }
+        }
+
+        void performFrequencyOnlyForwardTransform(float* data) noexcept override
+        {
+            const auto half = halfFFT.getSize();
+
+            if (getSize() < 2)
+            {
+                data[0] = std::abs(data[0]);
+                return;
+            }
+
+            auto* zr = halfFFT.getReal();
+            auto* zi = halfFFT.getImag();
+
+            for (int i = 0; i < half; ++i)
+            {
+                zr[i] = data[2 * i];
+                zi[i] = data[2 * i + 1];
+            }
+
+            halfFFT.perform();
+
+            for (int k = 0; k <= half; ++k)
+            {
+                auto a = k & (half - 1);
+                auto b = (half - k) & (half - 1);
+
+                auto evenRe = 0.5f * (zr[a] + zr[b]);
+                auto evenIm = 0.5f * (zi[a] - zi[b]);
+                auto oddRe = 0.5f * (zi[a] + zi[b]);
+                auto oddIm = -0.5f * (zr[a] - zr[b]);
+
+                auto re = evenRe + untangleRe[(size_t)k] * oddRe - untangleIm[(size_t)k] * oddIm;
+                auto im = evenIm + untangleRe[(size_t)k] * oddIm + untangleIm[(size_t)k] * oddRe;
+
+                data[k] = std::sqrt(re * re + im * im);
+            }
+        }
+
+        void perform(const juce::dsp::Complex<float>* input, juce::dsp::Complex<float>* output) noexcept override
+        {
+            const auto n = getSize();
+
+            auto* re = fullFFT.getReal();
+            auto* im = fullFFT.getImag();
+
+            for (int i = 0; i < n; ++i)
+            {
+                re[i] = input[i].real();
+                im[i] = input[i].imag();
+            }
+
+            fullFFT.perform();
+
+            for (int i = 0; i < n; ++i)
+                output[i] = { re[i], im[i] };
+        }
+
+        StockhamFFT fullFFT, halfFFT;
+        std::vector<float> untangleRe, untangleIm;
+    };
+}
+
+//==============================================================================
+std::unique_ptr<FFTBackend> createJuceFFTBackend(int order)
+{
+    return std::make_unique<JuceFFTBackend>(order);
+}
+
+std::unique_ptr<FFTBackend> createSIMDFFTBackend(int order)
+{
+    return std::make_unique<SIMDFFTBackend>(order);
+}
+
+std::unique_ptr<FFTBackend> createFFTBackend(int order)
+{
+#if TOKYOEQ_FFT_BACKEND == TOKYOEQ_FFT_BACKEND_SIMD
+    return createSIMDFFTBackend(order);
+#else
+    return createJuceFFTBackend(order);
+#endif
+}
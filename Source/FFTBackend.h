@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+    Forward FFTs for the analyzer, with the implementation chosen at build
+    time.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <memory>
+
+#define TOKYOEQ_FFT_BACKEND_JUCE 0   // juce::dsp::FFT, whatever engine JUCE was built with
+#define TOKYOEQ_FFT_BACKEND_SIMD 1   // the built-in SIMD Stockham transform below
+
+#ifndef TOKYOEQ_FFT_BACKEND
+ #if JUCE_MAC || JUCE_IOS
+  #define TOKYOEQ_FFT_BACKEND TOKYOEQ_FFT_BACKEND_JUCE   // JUCE already uses vDSP there
+ #else
+  #define TOKYOEQ_FFT_BACKEND TOKYOEQ_FFT_BACKEND_SIMD
+ #endif
+#endif
+
+/**
+ The two forward transforms FFTDataGenerator uses, with the same contracts as
+ the juce::dsp::FFT functions of the same names, so any engine can sit behind
+ it.
+ */
+struct FFTBackend
+{
+    virtual ~FFTBackend() = default;
+
+    int getSize() const noexcept { return 1 << order; }
+
+    /** In place. data holds 2 * getSize() floats with the real input in the first
+        half. Afterwards the first getSize() / 2 + 1 hold the magnitudes |X[k]|. */
+    virtual void performFrequencyOnlyForwardTransform(float* data) noexcept = 0;
+
+    // getSize() complex values in, getSize() out, unscaled
+    virtual void perform(const juce::dsp::Complex<float>* input, juce::dsp::Complex<float>* output) noexcept = 0;
+
+protected:
+    explicit FFTBackend(int fftOrder) : order(fftOrder) {}
+
+    const int order;
+};
+
+// The backend this build selected with TOKYOEQ_FFT_BACKEND
+std::unique_ptr<FFTBackend> createFFTBackend(int order);
+
+// Both are always built, so they can be compared (see the benchmark's --fft mode)
+std::unique_ptr<FFTBackend> createJuceFFTBackend(int order);
+std::unique_ptr<FFTBackend> createSIMDFFTBackend(int order);
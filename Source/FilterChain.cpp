@@ -0,0 +1,23 @@
+/*
+  ==============================================================================
+    The original juce::dsp::ProcessorChain filter path and the helpers that
+    load ChainCoefficients into it.
+  ==============================================================================
+*/
+
+#include "FilterChain.h"
+
+void updateCoefficients(Coefficients& old, const BiquadCoefficients& replacements)
+{
+    // Filters start out first order, so the first call (from prepareToPlay) grows the array.
+    // After that a biquad is always 5 floats and this writes in place without allocating.
+    if (old->coefficients.size() != 5)
+        old->coefficients.resize(5);
+
+    auto* raw = old->getRawCoefficients();
+    raw[0] = replacements.b0;
+    raw[1] = replacements.b1;
+    raw[2] = replacements.b2;
+    raw[3] = replacements.a1;
+    raw[4] = replacements.a2;
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+    The original juce::dsp::ProcessorChain filter path and the helpers that
+    load ChainCoefficients into it.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "FilterDesign.h"
+
+using Filter = juce::dsp::IIR::Filter<float>;
+using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+
+using Coefficients = Filter::CoefficientsPtr;
+void updateCoefficients(Coefficients& old, const BiquadCoefficients& replacements);
+
+//==============================================================================
+template<int Index, typename ChainType, typename CoefficientType>
+void update(ChainType& chain, const CoefficientType& coefficients)
+{
+    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
+    chain.template setBypassed<Index>(false);
+}
+
+//==============================================================================
+template<typename ChainType, typename CoefficientType>
+void updateCutFilter(ChainType& chain, const CoefficientType& coefficients, const Slope& slope)
+{
+    chain.template setBypassed<0>(true);
+    chain.template setBypassed<1>(true);
+    chain.template setBypassed<2>(true);
+    chain.template setBypassed<3>(true);
+
+    // Assigning coeff to the first filter in filter chain & stop bypassing
+    switch (slope)
+    {
+    case Slope_48:
+    {
+        update<3>(chain, coefficients);
+    }
+    case Slope_36:
+    {
+        update<2>(chain, coefficients);
+    }
+    case Slope_24:
+    {
+        update<1>(chain, coefficients);
+    }
+    case Slope_12:
+    {
+        update<0>(chain, coefficients);
+    }
+    }
+}
+
+//==============================================================================
+// Applies a published design to any chain laid out like MonoChain, whatever its sample type
+template<typename ChainType>
+void updateChainCoefficients(ChainType& chain, const ChainCoefficients& chainCoefficients)
+{
+    const auto& chainSettings = chainCoefficients.settings;
+
+    chain.template setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    chain.template setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    chain.template setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+
+    updateCutFilter(chain.template get<ChainPositions::LowCut>(), chainCoefficients.lowCut, chainSettings.lowCutSlope);
+    updateCoefficients(chain.template get<ChainPositions::Peak>().coefficients, chainCoefficients.peak);
+    updateCutFilter(chain.template get<ChainPositions::HighCut>(), chainCoefficients.highCut, chainSettings.highCutSlope);
+}
+
+// Gives every stage biquad-sized coefficients, including the ones the current slope bypasses,
+// so raising the slope or switching to this chain later never resizes anything on the audio thread
+template<typename ChainType>
+void prepareChainCoefficients(ChainType& chain)
+{
+    CutCoefficients passThrough;
+
+    updateCutFilter(chain.template get<ChainPositions::LowCut>(), passThrough, Slope::Slope_48);
+    updateCoefficients(chain.template get<ChainPositions::Peak>().coefficients, passThrough[0]);
+    updateCutFilter(chain.template get<ChainPositions::HighCut>(), passThrough, Slope::Slope_48);
+}
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+    Parameter snapshot and plain-data filter coefficients shared by the
+    processor, the background designer and the editor.
+  ==============================================================================
+*/
+
+#include "FilterDesign.h"
+
+#if JUCE_MODULE_AVAILABLE_juce_audio_processors
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) // init params
+{
+
+    ChainSettings settings;
+
+    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
+    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
+    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
+    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
+    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
+    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
+    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+
+    settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load() > 0.5f;
+    settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
+    settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load() > 0.5f;
+
+    return settings;
+}
+#endif
+
+//==============================================================================
+namespace
+{
+    /*
+     1 / Q of each section of an even order Butterworth filter:
+     2 * cos((2i + 1) * pi / (2 * order)), indexed by [slope][section].
+     Only the first (slope + 1) entries of a row are used.
+     */
+    constexpr double butterworthInverseQ[4][4]
+    {
+        { 1.4142135623730951 },                                                     // order 2
+        { 1.8477590650225735, 0.7653668647301797 },                                 // order 4
+        { 1.9318516525781366, 1.4142135623730951, 0.5176380902050415 },             // order 6
+        { 1.9615705608064609, 1.6629392246050905, 1.1111404660392046, 0.39018064403225666 } // order 8
+    };
+
+    // bilinear prewarp, kept just under Nyquist so tan() stays finite at low sample rates
+    double prewarp(float frequency, double sampleRate)
+    {
+        auto limited = juce::jlimit(1.0, sampleRate * 0.499, (double)frequency);
+        return std::tan(juce::MathConstants<double>::pi * limited / sampleRate);
+    }
+
+    SVFCoefficients makeSVF(double g, double k, double m0, double m1, double m2)
+    {
+        auto a1 = 1.0 / (1.0 + g * (g + k));
+        auto a2 = g * a1;
+        auto a3 = g * a2;
+
+        return { float(a1), float(a2), float(a3), float(m0), float(m1), float(m2) };
+    }
+
+    BiquadCoefficients normalise(double b0, double b1, double b2, double a0, double a1, double a2)
+    {
+        auto inverseA0 = 1.0 / a0;
+
+        return { float(b0 * inverseA0), float(b1 * inverseA0), float(b2 * inverseA0),
+                 float(a1 * inverseA0), float(a2 * inverseA0) };
+    }
+}
+
+void designButterworthHighPass(CutCoefficients& sections, float frequency, Slope slope, double sampleRate)
+{
+    const auto n = prewarp(frequency, sampleRate);
+    const auto nSquared = n * n;
+
+    for (int i = 0; i <= slope; ++i)
+    {
+        auto invQ = butterworthInverseQ[slope][i];
+        auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        sections[(size_t)i] = { float(c1), float(c1 * -2.0), float(c1),
+                                float(c1 * 2.0 * (nSquared - 1.0)),
+                                float(c1 * (1.0 - invQ * n + nSquared)) };
+    }
+}
+
+void designButterworthLowPass(CutCoefficients& sections, float frequency, Slope slope, double sampleRate)
+{
+    const auto n = 1.0 / prewarp(frequency, sampleRate);
+    const auto nSquared = n * n;
+
+    for (int i = 0; i <= slope; ++i)
+    {
+        auto invQ = butterworthInverseQ[slope][i];
+        auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        sections[(size_t)i] = { float(c1), float(c1 * 2.0), float(c1),
+                                float(c1 * 2.0 * (1.0 - nSquared)),
+                                float(c1 * (1.0 - invQ * n + nSquared)) };
+    }
+}
+
+BiquadCoefficients designPeakCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    auto A = std::sqrt(juce::Decibels::decibelsToGain((double)chainSettings.peakGainInDecibels));
+    auto frequency = juce::jlimit(2.0, sampleRate * 0.499, (double)chainSettings.peakFreq);
+    auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    auto alpha = std::sin(omega) / (chainSettings.peakQuality * 2.0);
+    auto c2 = -2.0 * std::cos(omega);
+
+    return normalise(1.0 + alpha * A, c2, 1.0 - alpha * A,
+                     1.0 + alpha / A, c2, 1.0 - alpha / A);
+}
+
+CutCoefficients designLowCutCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    CutCoefficients cut;
+    designButterworthHighPass(cut, chainSettings.lowCutFreq, chainSettings.lowCutSlope, sampleRate);
+    return cut;
+}
+
+CutCoefficients designHighCutCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    CutCoefficients cut;
+    designButterworthLowPass(cut, chainSettings.highCutFreq, chainSettings.highCutSlope, sampleRate);
+    return cut;
+}
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate)
+{
+    ChainCoefficients chainCoefficients;
+
+    chainCoefficients.settings = chainSettings;
+    chainCoefficients.lowCut = designLowCutCoefficients(chainSettings, sampleRate);
+    chainCoefficients.peak = designPeakCoefficients(chainSettings, sampleRate);
+    chainCoefficients.highCut = designHighCutCoefficients(chainSettings, sampleRate);
+
+    return chainCoefficients;
+}
+
+//==============================================================================
+SVFCoefficients designSVFPeak(const ChainSettings& chainSettings, double sampleRate)
+{
+    // bell: A = 10^(dB / 40), k = 1 / (Q * A), band pass mixed back in by k * (A^2 - 1)
+    auto A = std::sqrt(juce::Decibels::decibelsToGain((double)chainSettings.peakGainInDecibels));
+    auto g = prewarp(juce::jmax(2.f, chainSettings.peakFreq), sampleRate);
+    auto k = 1.0 / (chainSettings.peakQuality * A);
+
+    return makeSVF(g, k, 1.0, k * (A * A - 1.0), 0.0);
+}
+
+void designSVFHighPass(SVFCutCoefficients& sections, float frequency, Slope slope, double sampleRate)
+{
+    const auto g = prewarp(frequency, sampleRate);
+
+    for (int i = 0; i <= slope; ++i)
+    {
+        auto k = butterworthInverseQ[slope][i];
+        sections[(size_t)i] = makeSVF(g, k, 1.0, -k, -1.0);
+    }
+}
+
+void designSVFLowPass(SVFCutCoefficients& sections, float frequency, Slope slope, double sampleRate)
+{
+    const auto g = prewarp(frequency, sampleRate);
+
+    for (int i = 0; i <= slope; ++i)
+    {
+        auto k = butterworthInverseQ[slope][i];
+        sections[(size_t)i] = makeSVF(g, k, 0.0, 0.0, 1.0);
+    }
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+    Parameter snapshot and plain-data filter coefficients shared by the
+    processor, the background designer and the editor.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+enum Slope // slope amount
+{
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+struct ChainSettings // Data structure for all param values
+{
+    float peakFreq{ 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
+    float lowCutFreq{ 0 }, highCutFreq{ 0 };
+
+    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
+
+    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false };
+};
+
+#if JUCE_MODULE_AVAILABLE_juce_audio_processors
+// Helper function to get all param values from ChainSettings
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
+#endif
+
+enum ChainPositions
+{
+    LowCut,
+    Peak,
+    HighCut
+};
+
+//==============================================================================
+/**
+ One normalised biquad section, laid out like juce::dsp::IIR::Coefficients
+ stores a second order filter (b0, b1, b2, a1, a2 with a0 == 1).
+ Being plain data it can be copied across threads without touching the heap.
+ */
+struct BiquadCoefficients
+{
+    float b0{ 1.f }, b1{ 0.f }, b2{ 0.f }, a1{ 0.f }, a2{ 0.f };
+};
+
+// One section per 12 dB/Oct, so Slope_48 uses all four
+using CutCoefficients = std::array<BiquadCoefficients, 4>;
+
+struct ChainCoefficients
+{
+    CutCoefficients lowCut, highCut;
+    BiquadCoefficients peak;
+
+    // the settings these were designed from, for the slopes and bypass states
+    ChainSettings settings;
+};
+
+//==============================================================================
+/*
+ Closed-form designers. They match juce::dsp::IIR::Coefficients::makePeakFilter
+ and FilterDesign::designIIR*HighOrderButterworthMethod, but write plain data
+ straight into the result instead of building reference counted objects. That
+ makes them cheap and allocation free, so they can run on the audio thread.
+ */
+BiquadCoefficients designPeakCoefficients(const ChainSettings& chainSettings, double sampleRate);
+CutCoefficients designLowCutCoefficients(const ChainSettings& chainSettings, double sampleRate);
+CutCoefficients designHighCutCoefficients(const ChainSettings& chainSettings, double sampleRate);
+
+ChainCoefficients makeChainCoefficients(const ChainSettings& chainSettings, double sampleRate);
+
+// Fills the first (slope + 1) sections of a 2 * (slope + 1) order Butterworth cut
+void designButterworthHighPass(CutCoefficients& sections, float frequency, Slope slope, double sampleRate);
+void designButterworthLowPass(CutCoefficients& sections, float frequency, Slope slope, double sampleRate);
+
+//==============================================================================
+/**
+ One zero-delay-feedback state variable section (Cytomic's trapezoidal SVF).
+ g and k set the cutoff and damping, a1..a3 are derived from them and
+ m0..m2 mix input, band and low pass outputs into the response we want.
+ Cheap enough to recompute every few samples while a parameter is modulated.
+ */
+struct SVFCoefficients
+{
+    float a1{ 0.f }, a2{ 0.f }, a3{ 0.f };
+    float m0{ 1.f }, m1{ 0.f }, m2{ 0.f };
+};
+
+using SVFCutCoefficients = std::array<SVFCoefficients, 4>;
+
+SVFCoefficients designSVFPeak(const ChainSettings& chainSettings, double sampleRate);
+
+// Same Butterworth pole layout as designButterworthHighPass / designButterworthLowPass
+void designSVFHighPass(SVFCutCoefficients& sections, float frequency, Slope slope, double sampleRate);
+void designSVFLowPass(SVFCutCoefficients& sections, float frequency, Slope slope, double sampleRate);
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+    Sample history whose storage is mapped twice back to back, so the newest
+    N samples are always one contiguous run.
+  ==============================================================================
+*/
+
+#include "MirroredRing.h"
+
+#if JUCE_LINUX
+ #include <sys/mman.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#endif
+
+void MirroredRing::prepare(int minCapacity)
+{
+    release();
+
+    auto bytes = (size_t)juce::jmax(1, minCapacity) * sizeof(float);
+
+#if JUCE_LINUX
+    const auto pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const auto pageBytes = (bytes + pageSize - 1) / pageSize * pageSize;
+
+    if (mapMirrored(pageBytes))
+    {
+        capacity = (int)(pageBytes / sizeof(float));
+        return;
+    }
+#endif
+
+    capacity = (int)(bytes / sizeof(float));
+    fallback.allocate((size_t)capacity * 2, true);
+    data = fallback.get();
+}
+
+void MirroredRing::release()
+{
+#if JUCE_LINUX
+    if (mapped)
+        munmap(data, mappedBytes * 2);
+#endif
+
+    fallback.free();
+
+    data = nullptr;
+    capacity = 0;
+    writePosition = 0;
+    mapped = false;
+    mappedBytes = 0;
+}
+
+bool MirroredRing::mapMirrored(size_t bytes)
+{
+#if JUCE_LINUX
+    // the syscall rather than memfd_create(), which older glibc doesn't declare
+    const auto fd = (int)syscall(SYS_memfd_create, "TokyoEQ analyzer", 0u);
+
+    if (fd < 0)
+        return false;
+
+    auto* address = MAP_FAILED;
+
+    if (ftruncate(fd, (off_t)bytes) == 0)
+    {
+        // reserve both halves in one go, then put the same pages over each
+        address = mmap(nullptr, bytes * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (address != MAP_FAILED)
+        {
+            auto* first = static_cast<char*>(address);
+
+            if (mmap(first, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+                || mmap(first + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+            {
+                munmap(address, bytes * 2);
+                address = MAP_FAILED;
+            }
+        }
+    }
+
+    // the mappings keep the memory alive
+    close(fd);
+
+    if (address == MAP_FAILED)
+        return false;
+
+    data = static_cast<float*>(address);
+    mapped = true;
+    mappedBytes = bytes;
+    return true;
+#else
+    juce::ignoreUnused(bytes);
+    return false;
+#endif
+}
+
+void MirroredRing::advance(int numSamples) noexcept
+{
+    jassert(numSamples >= 0 && numSamples <= capacity);
+
+    if (numSamples <= 0)
+        return;
+
+    if (!mapped)
+    {
+        // copy what was just written into the other half
+        const auto end = writePosition + numSamples;
+        const auto inFirstHalf = juce::jmin(end, capacity) - writePosition;
+
+        if (inFirstHalf > 0)
+            juce::FloatVectorOperations::copy(data + writePosition + capacity, data + writePosition, inFirstHalf);
+
+        if (end > capacity)
+            juce::FloatVectorOperations::copy(data, data + capacity, end - capacity);
+    }
+
+    writePosition = (writePosition + numSamples) % capacity;
+}
+
+void MirroredRing::write(const float* samples, int numSamples) noexcept
+{
+    if (numSamples > capacity)
+    {
+        samples += numSamples - capacity;
+        numSamples = capacity;
+    }
+
+    juce::FloatVectorOperations::copy(getWritePointer(), samples, numSamples);
+    advance(numSamples);
+}
+
+void MirroredRing::clear() noexcept
+{
+    if (data != nullptr)
+        juce::FloatVectorOperations::clear(data, mapped ? capacity : capacity * 2);
+
+    writePosition = 0;
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+    Sample history whose storage is mapped twice back to back, so the newest
+    N samples are always one contiguous run.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ A sliding window over the most recent samples without ever shifting them.
+ New samples are written at the write position, and since the memory right
+ after the ring is the ring again, any run of up to getCapacity() samples
+ starting anywhere in it can be read or written with one pointer.
+
+ On Linux the same pages are mapped twice with memfd + mmap. Elsewhere, or if
+ mapping fails, the ring is twice the size and every write is copied into
+ both halves. That costs one extra copy of the new samples, still with no
+ shifting of the old ones.
+
+ Single threaded. Use it from the thread that owns the analysis.
+ */
+struct MirroredRing
+{
+    MirroredRing() = default;
+    ~MirroredRing() { release(); }
+
+    // Allocates at least minCapacity samples, rounded up to whole pages when mapped, all zero
+    void prepare(int minCapacity);
+    void release();
+
+    int getCapacity() const noexcept { return capacity; }
+    bool isPageMirrored() const noexcept { return mapped; }
+
+    // Room for up to getCapacity() samples, contiguous. Call advance() once they're written.
+    float* getWritePointer() noexcept { return data + writePosition; }
+    void advance(int numSamples) noexcept;
+
+    // copies in and advances, keeping only the last getCapacity() if there are more
+    void write(const float* samples, int numSamples) noexcept;
+
+    // the newest numSamples, oldest first, contiguous
+    const float* getNewest(int numSamples) const noexcept
+    {
+        jassert(numSamples <= capacity);
+        return data + writePosition + capacity - numSamples;
+    }
+
+    void clear() noexcept;
+
+private:
+    float* data = nullptr;
+    int capacity = 0;
+    int writePosition = 0;   // in [0, capacity)
+
+    bool mapped = false;
+    size_t mappedBytes = 0;
+    juce::HeapBlock<float> fallback;
+
+    bool mapMirrored(size_t bytes);
+
+    JUCE_DECLARE_NON_COPYABLE(MirroredRing)
+};
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+    Filters any number of channels with one shared design, SIMD across
+    channel groups.
+  ==============================================================================
+*/
+
+#include "MultiChannelBiquadEngine.h"
+
+#if JUCE_USE_SIMD
+
+void MultiChannelBiquadEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    constexpr auto width = SIMDFloat::size();
+    const auto numGroups = (spec.numChannels + width - 1) / width;
+
+    interleaved = juce::dsp::AudioBlock<SIMDFloat>(interleavedData, numGroups, spec.maximumBlockSize);
+    interleaved.clear();
+
+    cascades.resize(numGroups);
+    reset();
+}
+
+void MultiChannelBiquadEngine::reset()
+{
+    for (auto& cascade : cascades)
+        cascade.reset();
+}
+
+void MultiChannelBiquadEngine::updateCoefficients(const ChainCoefficients& chainCoefficients)
+{
+    for (auto& cascade : cascades)
+        cascade.setCoefficients(chainCoefficients);
+}
+
+bool MultiChannelBiquadEngine::canProcess(const juce::dsp::AudioBlock<float>& block) const
+{
+    return block.getNumChannels() <= interleaved.getNumChannels() * SIMDFloat::size()
+        && interleaved.getNumSamples() > 0;
+}
+
+void MultiChannelBiquadEngine::process(juce::dsp::AudioBlock<float>& block)
+{
+    jassert(canProcess(block));
+
+    constexpr auto width = SIMDFloat::size();
+
+    const auto numChannels = block.getNumChannels();
+    const auto numSamples = block.getNumSamples();
+    const auto capacity = interleaved.getNumSamples();
+
+    for (size_t firstChannel = 0, group = 0; firstChannel < numChannels; firstChannel += width, ++group)
+    {
+        const auto groupSize = juce::jmin(width, numChannels - firstChannel);
+
+        auto* frames = interleaved.getChannelPointer(group);
+        auto* lanes = reinterpret_cast<float*>(frames);
+
+        // hosts may exceed the block size they promised, so work through it in chunks
+        for (size_t start = 0; start < numSamples; start += capacity)
+        {
+            auto count = juce::jmin(capacity, numSamples - start);
+
+            for (size_t lane = 0; lane < groupSize; ++lane)
+            {
+                auto* channel = block.getChannelPointer(firstChannel + lane) + start;
+
+                for (size_t i = 0; i < count; ++i)
+                    lanes[i * width + lane] = channel[i];
+            }
+
+            cascades[group].process(frames, (int)count);
+
+            for (size_t lane = 0; lane < groupSize; ++lane)
+            {
+                auto* channel = block.getChannelPointer(firstChannel + lane) + start;
+
+                for (size_t i = 0; i < count; ++i)
+                    channel[i] = lanes[i * width + lane];
+            }
+        }
+    }
+}
+
+#else
+
+// no SIMD on this target, the processor stays on the scalar engines
+void MultiChannelBiquadEngine::prepare(const juce::dsp::ProcessSpec&) {}
+void MultiChannelBiquadEngine::reset() {}
+void MultiChannelBiquadEngine::updateCoefficients(const ChainCoefficients&) {}
+bool MultiChannelBiquadEngine::canProcess(const juce::dsp::AudioBlock<float>&) const { return false; }
+void MultiChannelBiquadEngine::process(juce::dsp::AudioBlock<float>&) {}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+    Filters any number of channels with one shared design, SIMD across
+    channel groups.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+#include "FilterDesign.h"
+#include "BiquadCascade.h"
+
+/**
+ Channels are packed into groups of SIMDRegister<float>::size() (4 with SSE
+ or NEON), one channel per lane, and each group runs through its own
+ BiquadCascade<SIMDRegister<float>>. Every group shares the same design, so a
+ biquad update filters a whole group in one instruction stream and the cost
+ grows with the number of groups rather than the number of channels. The
+ lanes of a partly filled last group stay silent.
+ */
+struct MultiChannelBiquadEngine
+{
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+    void updateCoefficients(const ChainCoefficients& chainCoefficients);
+
+    bool canProcess(const juce::dsp::AudioBlock<float>& block) const;
+    void process(juce::dsp::AudioBlock<float>& block);
+
+private:
+#if JUCE_USE_SIMD
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+
+    std::vector<BiquadCascade<SIMDFloat>> cascades;
+
+    // one SIMD channel per group, one SIMD "sample" per frame
+    juce::HeapBlock<char> interleavedData;
+    juce::dsp::AudioBlock<SIMDFloat> interleaved;
+#endif
+};
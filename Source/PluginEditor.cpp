@@ -222,17 +222,47 @@ ResponseCurveComponent::ResponseCurveComponent(TokyoEQAudioProcessor& p) :
 	rightPathProducer(audioProcessor.rightChannelFifo)
 {
 	const auto& params = audioProcessor.getParameters();
+
+	// which band each parameter index belongs to, so a change only redoes that band.
+	// Filled before listening, as callbacks can come from other threads.
+	for (auto param : params)
+	{
+		auto band = -1;
+		if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+		{
+			if		(withID->paramID.startsWith("LowCut"))	band = LowCut;
+			else if	(withID->paramID.startsWith("Peak"))	band = Peak;
+			else if	(withID->paramID.startsWith("HighCut"))	band = HighCut;
+		}
+		parameterBands.push_back(band);
+	}
+
 	for (auto param : params)
 	{
 		param->addListener(this);
 	}
 
-	updateChain();
+	markAllBandsChanged();
+
+	// the processor only captures audio for the analyzer while someone is showing it
+	shouldShowFFTAnalysis = audioProcessor.apvts.getRawParameterValue("Analyzer Enabled")->load() > 0.5f;
+	if (shouldShowFFTAnalysis)
+	{
+		audioProcessor.addAnalyzerConsumer();
+		analyzerThread.startThread();
+	}
+
 	startTimerHz(60);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+	if (shouldShowFFTAnalysis)
+	{
+		analyzerThread.stopThread(1000);
+		audioProcessor.removeAnalyzerConsumer();
+	}
+
 	const auto& params = audioProcessor.getParameters();
 	for (auto param : params)
 	{
@@ -240,57 +270,60 @@ ResponseCurveComponent::~ResponseCurveComponent()
 	}
 }
 
-void ResponseCurveComponent::updateResponseCurve()
+void ResponseCurveComponent::setAnalyzerMode(AnalyzerMode mode)
 {
-	using namespace juce;
-	auto responseArea = getAnalysisArea();
+	leftPathProducer.setAnalyzerMode(mode);
+	rightPathProducer.setAnalyzerMode(mode);
+}
 
-	auto w			 = responseArea.getWidth();
-	auto& lowcut	 = monoChain.get<ChainPositions::LowCut>();
-	auto& peak		 = monoChain.get<ChainPositions::Peak>();
-	auto& highcut	 = monoChain.get<ChainPositions::HighCut>();
-	auto sampleRate  = audioProcessor.getSampleRate();
+void ResponseCurveComponent::setAnalyzerOverlap(AnalyzerOverlap overlap)
+{
+	leftPathProducer.setOverlap(overlap);
+	rightPathProducer.setOverlap(overlap);
+}
+
+void ResponseCurveComponent::setAnalyzerColumnReduction(AnalyzerColumnReduction reduction)
+{
+	leftPathProducer.setColumnReduction(reduction);
+	rightPathProducer.setColumnReduction(reduction);
+}
 
-	std::vector<double> mags;
+void ResponseCurveComponent::toggleAnalysisEnablement(bool enabled)
+{
+	if (enabled == shouldShowFFTAnalysis)
+		return;
 
-	mags.resize(w);
+	shouldShowFFTAnalysis = enabled;
 
-	for (int i = 0; i < w; ++i)
+	// the thread reads the FIFOs, so it only runs while they exist
+	if (enabled)
 	{
-		double mag = 1.f;
-		auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-
-		if (!monoChain.isBypassed<ChainPositions::Peak>())
-			mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
+		audioProcessor.addAnalyzerConsumer();
+		analyzerThread.startThread();
+	}
+	else
+	{
+		analyzerThread.stopThread(1000);
+		audioProcessor.removeAnalyzerConsumer();
+	}
+}
 
-		if (!monoChain.isBypassed<ChainPositions::LowCut>())
-		{
-			if (!lowcut.isBypassed<0>())
-				mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!lowcut.isBypassed<1>())
-				mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!lowcut.isBypassed<2>())
-				mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!lowcut.isBypassed<3>())
-				mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		}
+void ResponseCurveComponent::updateResponseCurve()
+{
+	using namespace juce;
+	auto responseArea = getAnalysisArea();
 
-		if (!monoChain.isBypassed<ChainPositions::HighCut>())
-		{
-			if (!highcut.isBypassed<0>())
-				mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!highcut.isBypassed<1>())
-				mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!highcut.isBypassed<2>())
-				mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-			if (!highcut.isBypassed<3>())
-				mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-		}
+	responseCurve.clear();
 
-		mags[i] = Decibels::gainToDecibels(mag);
-	}
+	if (responseDecibels.empty())
+		return;
 
-	responseCurve.clear();
+	// the chain is the bands in cascade, so its dB is the sum of the cached bands' dB
+	auto numPoints = (int)responseDecibels.size();
+	FloatVectorOperations::add(responseDecibels.data(), bandDecibels[LowCut].data(), bandDecibels[Peak].data(), numPoints);
+	FloatVectorOperations::add(responseDecibels.data(), bandDecibels[HighCut].data(), numPoints);
+	FloatVectorOperations::max(responseDecibels.data(), responseDecibels.data(), -100.f, numPoints);
+	const auto& mags = responseDecibels;
 
 	const double outputMin = responseArea.getBottom();
 	const double outputMax = responseArea.getY();
@@ -307,90 +340,371 @@ void ResponseCurveComponent::updateResponseCurve()
 	}
 }
 
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
+void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float)
 {
-	parametersChanged.set(true);
+	// analyzer parameters don't touch the curve
+	if (juce::isPositiveAndBelow(parameterIndex, (int)parameterBands.size()) && parameterBands[(size_t)parameterIndex] >= 0)
+		bandChanged[(size_t)parameterBands[(size_t)parameterIndex]].set(true);
 }
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+void ResponseCurveComponent::markAllBandsChanged()
 {
-	juce::AudioBuffer<float> tempIncomingBuffer;
+	for (auto& changed : bandChanged)
+		changed.set(true);
+}
+
+bool ResponseCurveComponent::updateBands()
+{
+	auto w			 = getAnalysisArea().getWidth();
+	auto sampleRate  = audioProcessor.getSampleRate();
+
+	// the per-pixel table is only rebuilt when the width or sample rate change, and then every band is stale
+	if (responseEvaluator.prepare(w, sampleRate))
+	{
+		auto numPoints = (size_t)responseEvaluator.getNumPoints();
+		for (auto& band : bandDecibels)
+			band.resize(numPoints);
+		responseDecibels.resize(numPoints);
+
+		markAllBandsChanged();
+	}
 
-	while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
+	auto anyChanged = false;
+	ChainSettings chainSettings;
+
+	for (auto band : { LowCut, Peak, HighCut })
 	{
-		if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer)) // if there are more than 0 buffers available
+		if (!bandChanged[(size_t)band].compareAndSetBool(false, true))
+			continue;
+
+		if (!anyChanged)
+			chainSettings = getChainSettings(audioProcessor.apvts);
+
+		anyChanged = true;
+		updateBand(band, chainSettings, sampleRate);
+	}
+
+	return anyChanged;
+}
+
+void ResponseCurveComponent::updateBand(ChainPositions band, const ChainSettings& chainSettings, double sampleRate)
+{
+	chainCoefficients.settings = chainSettings;
+
+	switch (band)
+	{
+		case LowCut:	chainCoefficients.lowCut	= designLowCutCoefficients(chainSettings, sampleRate);	break;
+		case Peak:		chainCoefficients.peak		= designPeakCoefficients(chainSettings, sampleRate);	break;
+		case HighCut:	chainCoefficients.highCut	= designHighCutCoefficients(chainSettings, sampleRate);	break;
+	}
+
+	responseEvaluator.evaluate(chainCoefficients, band, bandDecibels[(size_t)band].data());
+}
+
+bool PathProducer::updateWindow()
+{
+	// Only the newest window is ever drawn, so everything that arrived since the last tick
+	// goes in at once, and at most one FFT runs however small the host's blocks are.
+	// The history always holds the largest order's window, whichever order is in use.
+	const auto historySize	= history.getCapacity();
+	const auto fftSize		= leftChannelFFTDataGen.getFFTSize();
+
+	// the processor rebuilds or frees the ring from the message thread on a re-prepare,
+	// in which case this tick just reads nothing
+	const juce::SpinLock::ScopedTryLockType ringScope(leftChannelFifo->getConsumerLock());
+
+	if (ringScope.isLocked() && leftChannelFifo->isPrepared())
+	{
+		auto available = leftChannelFifo->getNumSamplesAvailable();
+		samplesSinceLastFFT = juce::jmin(samplesSinceLastFFT + available, fftSize);
+
+		// anything older than the history would be overwritten straight away
+		if (available > historySize)
+			available -= leftChannelFifo->discardSamples(available - historySize);
+
+		if (available > 0)
 		{
-			auto size = tempIncomingBuffer.getNumSamples(); // shifting data
-			juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-											  monoBuffer.getReadPointer(0, size), //index size
-											  monoBuffer.getNumSamples() - size); // shift
+			// straight into the ring, whose mirroring keeps the write and every window contiguous
+			auto* newest = history.getWritePointer();
+			leftChannelFifo->pullSamples(newest, available);
 
-			juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-				tempIncomingBuffer.getReadPointer(0, 0),
-				size);
+			if (decimationFactor > 0)
+				decimateIntoLowBand(newest, available);
 
-			leftChannelFFTDataGen.produceFFTDataForRendering(monoBuffer, -48.f);
+			history.advance(available);
 		}
 	}
 
+	const auto hopSize = mode.get() == AnalyzerMode::latestFrameOnly ? 1 : juce::jmax(1, fftSize / (int)overlap.get());
+
+	if (samplesSinceLastFFT < hopSize)
+		return false;
+
+	samplesSinceLastFFT %= hopSize;
+	return true;
+}
+
+void PathProducer::setLowBandSampleRate(double sampleRate)
+{
+	decimationFactor		= sampleRate > 0.0 ? lowBandDecimation : 0;
+	decimationPhase			= 0;
+	samplesSinceLowBandFFT	= 0;
+
+	lowBandHistory.clear();
+	lowBandFrame.clear();
+
+	if (decimationFactor == 0)
+		return;
+
+	lowBandBinWidth = (float)(sampleRate / decimationFactor / lowBandFFTDataGen.getFFTSize());
+
+	auto designs = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(lowBandCutoffHz, sampleRate, 8);
+	jassert(designs.size() == (int)decimationFilters.size());
+
+	for (int i = 0; i < (int)decimationFilters.size(); ++i)
+	{
+		decimationFilters[(size_t)i].coefficients = designs[i];
+		decimationFilters[(size_t)i].reset();
+	}
+}
+
+void PathProducer::decimateIntoLowBand(const float* samples, int numSamples)
+{
+	auto numDecimated = 0;
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		auto sample = samples[i];
+
+		for (auto& filter : decimationFilters)
+			sample = filter.processSample(sample);
+
+		if (++decimationPhase == decimationFactor)
+		{
+			decimationPhase = 0;
+			decimated[(size_t)numDecimated++] = sample;
+		}
+	}
+
+	lowBandHistory.write(decimated.data(), numDecimated);
+
+	samplesSinceLowBandFFT = juce::jmin(samplesSinceLowBandFFT + numDecimated, lowBandFFTDataGen.getFFTSize());
+}
+
+bool PathProducer::updateLowBand()
+{
+	if (decimationFactor == 0)
+		return false;
+
+	const auto fftSize = lowBandFFTDataGen.getFFTSize();
+	const auto hopSize = mode.get() == AnalyzerMode::latestFrameOnly ? 1 : juce::jmax(1, fftSize / (int)overlap.get());
+
+	if (samplesSinceLowBandFFT < hopSize)
+		return false;
+
+	samplesSinceLowBandFFT %= hopSize;
+
+	lowBandFFTDataGen.produceFFTDataForRendering(lowBandHistory.getNewest(fftSize), -48.f);
+
+	auto gotFrame = false;
+
+	while (lowBandFFTDataGen.getNumAvailableFFTDataBlocks() > 0)
+		gotFrame = lowBandFFTDataGen.getFFTData(lowBandFrame) || gotFrame;
+
+	return gotFrame;
+}
+
+bool PathProducer::updatePath(juce::Rectangle<float> fftBounds, double sampleRate, bool lowBandChanged)
+{
 	const auto fftSize  = leftChannelFFTDataGen.getFFTSize();
 	const auto binWidth = sampleRate / (double)fftSize;
 
+	AnalyzerLowBand lowBand;
+
+	if (decimationFactor > 0 && !lowBandFrame.empty())
+		lowBand = { &lowBandFrame, lowBandFFTDataGen.getFFTSize(), lowBandBinWidth, lowBandCrossoverHz };
+
+	auto newFrame = false;
+
 	while (leftChannelFFTDataGen.getNumAvailableFFTDataBlocks() > 0)
 	{
-		std::vector<float> fftData;
-		if (leftChannelFFTDataGen.getFFTData(fftData)) // pull block
+		if (leftChannelFFTDataGen.getFFTData(fftFrame)) // pull block, into storage reserved for the largest order
 		{
-			pathProducer.generatePath(fftData, fftBounds, fftSize, binWidth, -48.f);
+			pathProducer.generatePath(fftFrame, fftBounds, fftSize, binWidth, -48.f, lowBand);
+			newFrame = true;
 		}
 	}
 
+	// the low band updates less often than the main FFT, and on its own schedule
+	if (!newFrame && lowBandChanged && !fftFrame.empty())
+		pathProducer.generatePath(fftFrame, fftBounds, fftSize, binWidth, -48.f, lowBand);
+
+	auto pathChanged = false;
+
 	while (pathProducer.getNumPathsAvailable())
 	{
-		pathProducer.getPath(leftChannelFFTPath);
+		pathChanged = pathProducer.getPath(leftChannelFFTPath) || pathChanged;
 	}
 
+	return pathChanged;
 }
 
-void ResponseCurveComponent::timerCallback()
+//==============================================================================
+AnalyzerThread::AnalyzerThread(PathProducer& left, PathProducer& right) :
+	juce::Thread("TokyoEQ Analyzer"),
+	leftPathProducer(left),
+	rightPathProducer(right)
 {
+}
 
-	if (shouldShowFFTAnalysis)
+AnalyzerThread::~AnalyzerThread()
+{
+	stopThread(1000);
+}
+
+void AnalyzerThread::setAnalysisArea(juce::Rectangle<float> bounds, double sampleRate)
+{
+	const juce::SpinLock::ScopedLockType lock(areaLock);
+
+	analysisBounds		= bounds;
+	analysisSampleRate	= sampleRate;
+}
+
+FFTOrder AnalyzerThread::getOrderToUse()
+{
+	switch (resolution.get())
 	{
-		auto fftBounds  = getAnalysisArea().toFloat();
-		auto sampleRate = audioProcessor.getSampleRate();
+		case AnalyzerResolution::resolution2048:
+		case AnalyzerResolution::multiResolution:	return FFTOrder::order2048;
+		case AnalyzerResolution::resolution4096:	return FFTOrder::order4096;
+		case AnalyzerResolution::resolution8192:	return FFTOrder::order8192;
+		case AnalyzerResolution::autoResolution:
+		default:									return autoOrder;
+	}
+}
+
+void AnalyzerThread::updateAutoOrder(double frameMs)
+{
+	averageFrameMs = framesAtAutoOrder == 0 ? frameMs : averageFrameMs + 0.1 * (frameMs - averageFrameMs);
+
+	if (++framesAtAutoOrder < minFramesPerOrder)
+		return;
+
+	auto newOrder = autoOrder;
 
-		leftPathProducer.process  (fftBounds, sampleRate);
-		rightPathProducer.process (fftBounds, sampleRate);
+	if (averageFrameMs > frameBudgetMs && autoOrder > FFTOrder::order2048)
+		newOrder = (FFTOrder)(autoOrder - 1);
+	else if (averageFrameMs * stepUpHeadroom < frameBudgetMs && autoOrder < FFTOrder::order8192)
+		newOrder = (FFTOrder)(autoOrder + 1);
+
+	if (newOrder != autoOrder)
+	{
+		autoOrder			= newOrder;
+		framesAtAutoOrder	= 0;
 	}
+}
 
-	if (parametersChanged.compareAndSetBool(false, true))
+void AnalyzerThread::run()
+{
+	while (!threadShouldExit())
 	{
-		DBG("params changed");
+		juce::Rectangle<float> bounds;
+		double sampleRate;
 
-		updateChain(); //update monochain
-		updateResponseCurve();
-	}
+		{
+			const juce::SpinLock::ScopedLockType lock(areaLock);
 
-	repaint();
+			bounds		= analysisBounds;
+			sampleRate	= analysisSampleRate;
+		}
+
+		if (!bounds.isEmpty() && sampleRate > 0.0)
+		{
+			// every order was allocated up front, so this only switches between them
+			const auto order = getOrderToUse();
+
+			if (order != currentOrder)
+			{
+				leftPathProducer.setOrder(order);
+				rightPathProducer.setOrder(order);
+				currentOrder		= order;
+				framesAtAutoOrder	= 0;
+			}
+
+			const auto lowBandRate = resolution.get() == AnalyzerResolution::multiResolution ? sampleRate : 0.0;
+
+			if (lowBandRate != currentLowBandRate)
+			{
+				leftPathProducer.setLowBandSampleRate(lowBandRate);
+				rightPathProducer.setLowBandSampleRate(lowBandRate);
+				currentLowBandRate = lowBandRate;
+			}
+
+			const auto frameStart = juce::Time::getHighResolutionTicks();
+
+			auto leftDue  = leftPathProducer.updateWindow();
+			auto rightDue = rightPathProducer.updateWindow();
+
+			if (stereoTransform.get())
+			{
+				// both channels are fed the same blocks, so their frames fall due together
+				if (leftDue || rightDue)
+					leftPathProducer.getFFTDataGenerator().produceStereoFFTDataForRendering(leftPathProducer.getWindow(),
+																							rightPathProducer.getWindow(),
+																							rightPathProducer.getFFTDataGenerator(),
+																							-48.f);
+			}
+			else
+			{
+				if (leftDue)
+					leftPathProducer.getFFTDataGenerator().produceFFTDataForRendering(leftPathProducer.getWindow(), -48.f);
+
+				if (rightDue)
+					rightPathProducer.getFFTDataGenerator().produceFFTDataForRendering(rightPathProducer.getWindow(), -48.f);
+			}
+
+			auto leftLowBand  = leftPathProducer.updateLowBand();
+			auto rightLowBand = rightPathProducer.updateLowBand();
+
+			auto leftChanged  = leftPathProducer.updatePath  (bounds, sampleRate, leftLowBand);
+			auto rightChanged = rightPathProducer.updatePath (bounds, sampleRate, rightLowBand);
+
+			if (leftChanged || rightChanged)
+			{
+				auto& frame = frames.getWriteBuffer();
+				frame.left	= leftPathProducer.getPath();
+				frame.right	= rightPathProducer.getPath();
+				frames.publish();
+			}
+
+			// only frames that did the work count towards the average
+			if ((leftDue || rightDue) && resolution.get() == AnalyzerResolution::autoResolution)
+				updateAutoOrder(1000.0 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - frameStart));
+		}
+
+		wait(frameIntervalMs);
+	}
 }
 
-void ResponseCurveComponent::updateChain()
+//==============================================================================
+void ResponseCurveComponent::timerCallback()
 {
-	auto chainSettings = getChainSettings(audioProcessor.apvts);
-
-	monoChain.setBypassed<ChainPositions::LowCut>  (chainSettings.lowCutBypassed);
-	monoChain.setBypassed<ChainPositions::Peak>    (chainSettings.peakBypassed);
-	monoChain.setBypassed<ChainPositions::HighCut> (chainSettings.highCutBypassed);
 
-	auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-	updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+	if (shouldShowFFTAnalysis)
+	{
+		// the analysis itself runs on analyzerThread, this only hands it the area and picks up results
+		analyzerThread.setAnalysisArea(getAnalysisArea().toFloat(), audioProcessor.getSampleRate());
+		analyzerThread.setResolution((AnalyzerResolution)(int)audioProcessor.apvts.getRawParameterValue("Analyzer Resolution")->load());
+		setAnalyzerMode((AnalyzerMode)(int)audioProcessor.apvts.getRawParameterValue("Analyzer Mode")->load());
+		setAnalyzerOverlap(audioProcessor.apvts.getRawParameterValue("Analyzer Overlap")->load() < 0.5f ? AnalyzerOverlap::overlap50 : AnalyzerOverlap::overlap75);
+		analyzerThread.pullFrame();
+	}
 
-	auto lowCutCoefficients  = makeLowCutFilter(chainSettings,  audioProcessor.getSampleRate());
-	auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
+	// only the bands whose parameters moved are redesigned and re-evaluated
+	if (updateBands())
+		updateResponseCurve();
 
-	updateCutFilter(monoChain.get<ChainPositions::LowCut>(),  lowCutCoefficients,  chainSettings.lowCutSlope);
-	updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.highCutSlope);
+	repaint();
 }
 
 void ResponseCurveComponent::paint(juce::Graphics& g)
@@ -405,17 +719,14 @@ void ResponseCurveComponent::paint(juce::Graphics& g)
 
 	if (shouldShowFFTAnalysis)
 	{
-		auto leftChannelFFTPath = leftPathProducer.getPath();
-		leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
+		const auto& frame	= analyzerThread.getFrame();
+		auto toResponseArea	= AffineTransform::translation(responseArea.getX(), responseArea.getY());
 
 		g.setColour(Colour(97u, 18u, 167u)); //purple-
-		g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
-
-		auto rightChannelFFTPath = rightPathProducer.getPath();
-		rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX(), responseArea.getY()));
+		g.strokePath(frame.left, PathStrokeType(1.f), toResponseArea);
 
 		g.setColour(Colour(215u, 201u, 134u));
-		g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
+		g.strokePath(frame.right, PathStrokeType(1.f), toResponseArea);
 	}
 
 	g.setColour(Colours::white);
@@ -515,6 +826,7 @@ void ResponseCurveComponent::resized()
 	using namespace juce;
 
 	responseCurve.preallocateSpace(getWidth() * 3);
+	updateBands();
 	updateResponseCurve();
 }
 
@@ -8,6 +8,11 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "TripleBuffer.h"
+#include "FFTBackend.h"
+#include "SpectrumMath.h"
+#include "MirroredRing.h"
+#include "ResponseCurveEvaluator.h"
 
 enum FFTOrder
 {
@@ -16,104 +21,184 @@ enum FFTOrder
     order8192 = 13
 };
 
+enum AnalyzerMode
+{
+    hopped,             // a new frame once every hop of new samples
+    latestFrameOnly     // a new frame every tick there's new audio, hop ignored
+};
+
+enum AnalyzerOverlap    // hop = FFT size / overlap
+{
+    overlap50 = 2,
+    overlap75 = 4
+};
+
+enum AnalyzerColumnReduction   // how a pixel column spanning several bins picks its level
+{
+    columnMax,
+    columnMean
+};
+
+enum AnalyzerResolution   // the "Analyzer Resolution" parameter's choices
+{
+    autoResolution,       // the largest order whose frames fit the analyzer's time budget
+    resolution2048,
+    resolution4096,
+    resolution8192,
+    multiResolution       // 2048, with a decimated FFT of its own for the low end that's as fine, and as slow, as 8192
+};
+
 template<typename BlockType>
 struct FFTDataGenerator
 {
     /**
-     produces the FFT data from an audio buffer.
+     produces the FFT data from the getFFTSize() samples at 'audioData'.
      */
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    void produceFFTDataForRendering(const float* audioData, const float negativeInfinity)
     {
         const auto fftSize = getFFTSize();
+        auto& resolution = getResolution();
 
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
-
-        // first apply a windowing function to our data
-        window->multiplyWithWindowingTable(fftData.data(), fftSize);       // [1]
+        // copy and window in one pass. The transform only reads the first half, so the rest isn't cleared
+        juce::FloatVectorOperations::multiply(fftData.data(), audioData, resolution.windowTable.data(), fftSize);   // [1]
 
         // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
+        resolution.forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());  // [2]
 
-        int numBins = (int)fftSize / 2;
+        magnitudesToDecibels(fftData.data(), fftData.data(), fftSize / 2, 1.f / float(fftSize / 2), negativeInfinity);
+        fftDataFifo.push(fftData);
+    }
 
-        //normalize the fft values.
-        for (int i = 0; i < numBins; ++i)
-        {
-            auto v = fftData[i];
-            //            fftData[i] /= (float) numBins;
-            if (!std::isinf(v) && !std::isnan(v))
-            {
-                v /= float(numBins);
-            }
-            else
-            {
-                v = 0.f;
-            }
-            fftData[i] = v;
-        }
+    /**
+     produces the FFT data for two channels from a single complex transform.
+     Left goes in as the real part and right as the imaginary part, and the two
+     spectra are separated again using the conjugate symmetry of real signals:
+         L[k] = (X[k] + conj(X[N - k])) / 2,    R[k] = (X[k] - conj(X[N - k])) / 2j
+     The results match produceFFTDataForRendering on each channel. This
+     generator gets the left channel's data and 'rightGenerator' the right's.
+     */
+    void produceStereoFFTDataForRendering(const float* leftData,
+                                          const float* rightData,
+                                          FFTDataGenerator& rightGenerator,
+                                          const float negativeInfinity)
+    {
+        jassert(rightGenerator.getFFTSize() == getFFTSize());
 
-        //convert them to decibels
-        for (int i = 0; i < numBins; ++i)
-        {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
-        }
+        const auto fftSize = getFFTSize();
+        const auto numBins = fftSize / 2;
+        auto& resolution = getResolution();
+        const auto* windowTable = resolution.windowTable.data();
+
+        for (int i = 0; i < fftSize; ++i)
+            complexInput[(size_t)i] = { leftData[i] * windowTable[i], rightData[i] * windowTable[i] };
+
+        resolution.forwardFFT->perform(complexInput.data(), complexOutput.data());
+
+        packedSpectrumToDecibels(complexOutput.data(), fftSize, fftData.data(), rightGenerator.fftData.data(),
+                                 numBins, 1.f / float(numBins), negativeInfinity);
 
         fftDataFifo.push(fftData);
+        rightGenerator.fftDataFifo.push(rightGenerator.fftData);
     }
 
-    void changeOrder(FFTOrder newOrder)
+    /**
+     creates the transform and window for every order up to maxOrder, and sizes
+     fftData and the fifo for maxOrder, so changeOrder() never allocates.
+     */
+    void prepare(FFTOrder maxOrder = order8192)
     {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
+        for (int i = 0; i <= maxOrder - order2048; ++i)
+        {
+            const auto fftSize = 1 << (order2048 + i);
+            auto& resolution = resolutions[(size_t)i];
 
-        order = newOrder;
-        auto fftSize = getFFTSize();
+            resolution.forwardFFT = createFFTBackend(order2048 + i);
 
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
+            resolution.windowTable.resize((size_t)fftSize);
+            juce::dsp::WindowingFunction<float>::fillWindowingTables(resolution.windowTable.data(), (size_t)fftSize,
+                                                                     juce::dsp::WindowingFunction<float>::blackmanHarris);
+        }
+
+        const auto maxFFTSize = 1 << maxOrder;
 
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
+        fftData.assign((size_t)maxFFTSize * 2, 0);
+        complexInput.resize((size_t)maxFFTSize);
+        complexOutput.resize((size_t)maxFFTSize);
 
         fftDataFifo.prepare(fftData.size());
+
+        changeOrder(order2048);
+    }
+
+    // only picks which of the prepared orders is used, so it's safe to call between any two frames.
+    // Nothing above prepare()'s maxOrder is prepared.
+    void changeOrder(FFTOrder newOrder)
+    {
+        jassert(resolutions[(size_t)(newOrder - order2048)].forwardFFT != nullptr);
+
+        order = newOrder;
+
+        // within the capacity from prepare()
+        fftData.resize((size_t)getFFTSize() * 2);
     }
     //==============================================================================
     int getFFTSize() const { return 1 << order; }
+    FFTOrder getOrder() const { return order; }
     int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
     //==============================================================================
     bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
+
+    static constexpr int numOrders = order8192 - order2048 + 1;
 private:
-    FFTOrder order;
+    struct Resolution
+    {
+        std::unique_ptr<FFTBackend> forwardFFT;   // picked at build time, see FFTBackend.h
+        std::vector<float> windowTable;
+    };
+
+    std::array<Resolution, numOrders> resolutions;
+    Resolution& getResolution() { return resolutions[(size_t)(order - order2048)]; }
+
+    FFTOrder order = order2048;
     BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+
+    // room for the stereo complex transform
+    std::vector<juce::dsp::Complex<float>> complexInput, complexOutput;
 
     Fifo<BlockType> fftDataFifo;
 };
 
+// A finer spectrum of the low end, drawn below 'crossoverFreq' in place of the main one
+struct AnalyzerLowBand
+{
+    const std::vector<float>* renderData = nullptr;
+    int fftSize = 0;
+    float binWidth = 0.f;
+    float crossoverFreq = 0.f;
+};
+
 template<typename PathType>
 struct AnalyzerPathGenerator
 {
     /*
-     converts 'renderData[]' into a juce::Path
+     converts 'renderData[]' into a juce::Path, one point per pixel column,
+     taking the columns below the crossover from 'lowBand' when it has data
      */
     void generatePath(const std::vector<float>& renderData,
         juce::Rectangle<float> fftBounds,
         int fftSize,
         float binWidth,
-        float negativeInfinity)
+        float negativeInfinity,
+        const AnalyzerLowBand& lowBand = {})
     {
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
         auto width = fftBounds.getWidth();
 
-        int numBins = (int)fftSize / 2;
+        updateColumns(width, fftSize, binWidth, lowBand.renderData != nullptr ? lowBand : AnalyzerLowBand{});
 
         PathType p;
-        p.preallocateSpace(3 * (int)fftBounds.getWidth());
+        p.preallocateSpace(3 * (int)columns.size());
 
         auto map = [bottom, top, negativeInfinity](float v)
         {
@@ -122,34 +207,35 @@ struct AnalyzerPathGenerator
                 float(bottom + 10), top);
         };
 
-        auto y = map(renderData[0]);
-
-        //        jassert( !std::isnan(y) && !std::isinf(y) );
-        if (std::isnan(y) || std::isinf(y))
-            y = bottom;
+        const auto reduction = columnReduction.get();
 
-        p.startNewSubPath(0, y);
-
-        const int pathResolution = 2; //you can draw line-to's every 'pathResolution' pixels.
-
-        for (int binNum = 1; binNum < numBins; binNum += pathResolution)
+        // the dB values from SpectrumMath are always finite, so no point needs checking
+        for (size_t x = 0; x < columns.size(); ++x)
         {
-            y = map(renderData[binNum]);
+            const auto& column = columns[x];
+            const auto* bins = (column.lowBand ? lowBand.renderData->data() : renderData.data()) + column.firstBin;
 
-            //            jassert( !std::isnan(y) && !std::isinf(y) );
+            float v;
+
+            if (column.numBins == 0)
+                v = bins[0] + column.fraction * (bins[1] - bins[0]);
+            else if (reduction == AnalyzerColumnReduction::columnMax)
+                v = *std::max_element(bins, bins + column.numBins);
+            else
+                v = std::accumulate(bins, bins + column.numBins, 0.f) / (float)column.numBins;
 
-            if (!std::isnan(y) && !std::isinf(y))
-            {
-                auto binFreq = binNum * binWidth;
-                auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-                int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
-            }
+            if (x == 0)
+                p.startNewSubPath(0, map(v));
+            else
+                p.lineTo((float)x, map(v));
         }
 
         pathFifo.push(p);
     }
 
+    // safe to call from any thread while another generates paths
+    void setColumnReduction(AnalyzerColumnReduction newReduction) { columnReduction.set(newReduction); }
+
     int getNumPathsAvailable() const
     {
         return pathFifo.getNumAvailableForReading();
@@ -161,6 +247,89 @@ struct AnalyzerPathGenerator
     }
 private:
     Fifo<PathType> pathFifo;
+
+    /*
+     Which bins each pixel column of the log frequency axis covers, rebuilt only
+     when the width, FFT sizes or sample rate change. At the high end a column
+     spans many bins and reduces them. At the low end, where bins are further
+     apart than columns, it interpolates between the two around its centre.
+     */
+    struct Column
+    {
+        int firstBin = 0;
+        int numBins = 0;        // 0 to interpolate between firstBin and firstBin + 1
+        float fraction = 0.f;
+        bool lowBand = false;   // bins of the low band's spectrum rather than the main one
+    };
+
+    std::vector<Column> columns;
+    float mappedWidth = 0.f, mappedBinWidth = 0.f;
+    int mappedFFTSize = 0;
+    AnalyzerLowBand mappedLowBand;
+
+    juce::Atomic<AnalyzerColumnReduction> columnReduction{ AnalyzerColumnReduction::columnMax };
+
+    void updateColumns(float width, int fftSize, float binWidth, const AnalyzerLowBand& lowBand)
+    {
+        if (width == mappedWidth && fftSize == mappedFFTSize && binWidth == mappedBinWidth
+            && lowBand.fftSize == mappedLowBand.fftSize && lowBand.binWidth == mappedLowBand.binWidth
+            && lowBand.crossoverFreq == mappedLowBand.crossoverFreq)
+            return;
+
+        mappedWidth = width;
+        mappedFFTSize = fftSize;
+        mappedBinWidth = binWidth;
+        mappedLowBand = lowBand;
+
+        columns.clear();
+
+        const auto numColumns = (int)std::ceil(width);
+
+        auto columnFreq = [width](float x) { return juce::mapToLog10(x / width, 20.f, 20000.f); };
+
+        for (int x = 0; x < numColumns; ++x)
+        {
+            const auto lowEdge = columnFreq((float)x);
+            const auto highEdge = columnFreq((float)(x + 1));
+            const auto centre = columnFreq((float)x + 0.5f);
+
+            Column column;
+            column.lowBand = lowBand.fftSize > 0 && highEdge <= lowBand.crossoverFreq;
+
+            const auto ok = column.lowBand ? mapColumn(lowEdge, highEdge, centre, lowBand.binWidth, lowBand.fftSize / 2, column)
+                                           : mapColumn(lowEdge, highEdge, centre, binWidth, fftSize / 2, column);
+
+            // nothing left below Nyquist
+            if (!ok)
+                break;
+
+            columns.push_back(column);
+        }
+    }
+
+    // fills in the bins between two frequencies, returning false if they're past the last bin
+    static bool mapColumn(float lowEdge, float highEdge, float centre, float binWidth, int numBins, Column& column)
+    {
+        // the bins whose centres fall inside the column
+        auto first = juce::jmax(1, (int)std::ceil(lowEdge / binWidth));
+        auto last = juce::jmin(numBins - 1, (int)std::ceil(highEdge / binWidth) - 1);
+
+        if (last >= first)
+        {
+            column.firstBin = first;
+            column.numBins = last - first + 1;
+        }
+        else
+        {
+            auto bin = centre / binWidth;
+            column.firstBin = (int)bin;
+            column.fraction = bin - (float)column.firstBin;
+        }
+
+        const auto lastBinRead = column.numBins > 0 ? column.firstBin + column.numBins - 1 : column.firstBin + 1;
+
+        return lastBinRead <= numBins - 1;
+    }
 };
 
 struct LookAndFeel : juce::LookAndFeel_V4 // Look & feel to draw rotary sliders
@@ -220,20 +389,145 @@ struct PathProducer
     PathProducer(SingleChannelSampleFifo<TokyoEQAudioProcessor::BlockType>& scsf) :
         leftChannelFifo(&scsf)
     {
-        leftChannelFFTDataGen.changeOrder(FFTOrder::order2048);
-        monoBuffer.setSize(1, leftChannelFFTDataGen.getFFTSize());
+        // every order is ready up front, and the history is long enough for the largest,
+        // so switching order takes effect on the next frame without a gap
+        leftChannelFFTDataGen.prepare();
+        history.prepare(1 << FFTOrder::order8192);
+        fftFrame.reserve((size_t)(2 << FFTOrder::order8192));
+
+        // the low band only ever runs lowBandOrder, so that's all it prepares, and it
+        // only needs its sample rate once it's turned on
+        lowBandFFTDataGen.prepare(lowBandOrder);
+        lowBandFFTDataGen.changeOrder(lowBandOrder);
+        lowBandHistory.prepare(lowBandFFTDataGen.getFFTSize());
+        lowBandFrame.reserve((size_t)lowBandFFTDataGen.getFFTSize() * 2);
+        decimated.resize((size_t)history.getCapacity());
     }
 
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
-    juce::Path getPath() { return leftChannelFFTPath; }
+    const juce::Path& getPath() const { return leftChannelFFTPath; }
+
+    // Split into stages so two producers can share one stereo transform:
+    // updateWindow() says whether a new frame is due, then after the FFT data has been
+    // produced updatePath() turns it into the path, returning true if the path changed.
+    // In between, updateLowBand() runs the low band's own FFT when that's due.
+    bool updateWindow();
+    bool updateLowBand();
+    bool updatePath(juce::Rectangle<float> fftBounds, double sampleRate, bool lowBandChanged);
+
+    // the newest getFFTSize() samples
+    const float* getWindow() const { return history.getNewest(leftChannelFFTDataGen.getFFTSize()); }
+    FFTDataGenerator<std::vector<float>>& getFFTDataGenerator() { return leftChannelFFTDataGen; }
+
+    // safe to call from any thread while the analyzer thread is using the producer
+    void setAnalyzerMode(AnalyzerMode newMode) { mode.set(newMode); }
+    void setOverlap(AnalyzerOverlap newOverlap) { overlap.set(newOverlap); }
+    void setColumnReduction(AnalyzerColumnReduction newReduction) { pathProducer.setColumnReduction(newReduction); }
+
+    // from the thread running updateWindow() and updatePath()
+    void setOrder(FFTOrder newOrder) { leftChannelFFTDataGen.changeOrder(newOrder); }
+
+    /**
+     Multi-resolution: the input is also low-passed, decimated by
+     lowBandDecimation and analysed with its own lowBandOrder FFT. The columns
+     below lowBandCrossoverHz get order8192's bin width, and its window length,
+     so the low end lags no more than at order8192. Everything above keeps the
+     main FFT's faster response. 0 turns it off.
+     */
+    void setLowBandSampleRate(double sampleRate);
 
 private:
     SingleChannelSampleFifo<TokyoEQAudioProcessor::BlockType>* leftChannelFifo;
-    juce::AudioBuffer<float> monoBuffer;
+    MirroredRing history;   // every window is a pointer into it, nothing is shifted
+
+    juce::Atomic<AnalyzerMode> mode{ AnalyzerMode::hopped };
+    juce::Atomic<AnalyzerOverlap> overlap{ AnalyzerOverlap::overlap75 };
+    int samplesSinceLastFFT = 0;
+
     FFTDataGenerator<std::vector<float>> leftChannelFFTDataGen;
+    std::vector<float> fftFrame;
     AnalyzerPathGenerator<juce::Path> pathProducer;
     juce::Path leftChannelFFTPath;
+
+    void decimateIntoLowBand(const float* samples, int numSamples);
+
+    FFTDataGenerator<std::vector<float>> lowBandFFTDataGen;
+    MirroredRing lowBandHistory;
+    std::vector<float> lowBandFrame, decimated;
+    std::array<juce::dsp::IIR::Filter<float>, 4> decimationFilters;   // 8th order Butterworth
+    int decimationFactor = 0;   // 0 while the low band is off
+    int decimationPhase = 0;
+    int samplesSinceLowBandFFT = 0;
+    float lowBandBinWidth = 0.f;
+
+    // A 2048 point window at a quarter of the rate spans the same time as 8192 at the full rate,
+    // giving order8192's 5.4 Hz bins at 44.1k where the main FFT's are 21.5 Hz
+    static constexpr FFTOrder lowBandOrder = FFTOrder::order2048;
+    static constexpr int lowBandDecimation = 1 << (FFTOrder::order8192 - lowBandOrder);
+    static constexpr float lowBandCutoffHz = 1000.f;      // what aliases below the crossover starts above 10 kHz, 150+ dB down
+    static constexpr float lowBandCrossoverHz = 500.f;
+};
+struct AnalyzerFrame
+{
+    juce::Path left, right;
 };
+
+/**
+ Drains the analyzer FIFOs, runs the FFTs and builds both channels' paths on
+ its own thread, so none of it competes with the host's message thread. The
+ editor only picks up the newest finished frame.
+ */
+struct AnalyzerThread : juce::Thread
+{
+    AnalyzerThread(PathProducer& left, PathProducer& right);
+    ~AnalyzerThread() override;
+
+    // Message thread
+    void setAnalysisArea(juce::Rectangle<float> bounds, double sampleRate);
+
+    // both channels through one complex FFT (the default), or one real FFT each
+    void setStereoTransform(bool shouldPackChannels) { stereoTransform.set(shouldPackChannels); }
+
+    // a fixed FFT order, or autoResolution to let the measured time per frame pick one
+    void setResolution(AnalyzerResolution newResolution) { resolution.set(newResolution); }
+
+    bool pullFrame() { return frames.pull(); }
+    const AnalyzerFrame& getFrame() const { return frames.getReadBuffer(); }
+
+private:
+    void run() override;
+
+    PathProducer& leftPathProducer;
+    PathProducer& rightPathProducer;
+
+    juce::SpinLock areaLock;
+    juce::Rectangle<float> analysisBounds;
+    double analysisSampleRate = 0.0;
+
+    TripleBuffer<AnalyzerFrame> frames;
+
+    juce::Atomic<bool> stereoTransform{ true };
+    juce::Atomic<AnalyzerResolution> resolution{ AnalyzerResolution::resolution2048 };
+
+    // Analyzer thread only
+    FFTOrder getOrderToUse();
+    void updateAutoOrder(double frameMs);
+
+    FFTOrder currentOrder = FFTOrder::order2048;
+    FFTOrder autoOrder = FFTOrder::order2048;
+    double currentLowBandRate = 0.0;
+    double averageFrameMs = 0.0;
+    int framesAtAutoOrder = 0;
+
+    // one frame per display refresh
+    static constexpr int frameIntervalMs = 16;
+
+    // In auto, step down when a frame averages more than the budget, and up when the next
+    // order (a little over twice the work) would still fit with room to spare
+    static constexpr double frameBudgetMs = 2.0;
+    static constexpr double stepUpHeadroom = 3.0;
+    static constexpr int minFramesPerOrder = 30;   // lets the average settle between steps
+};
+
 struct ResponseCurveComponent : juce::Component,
     juce::AudioProcessorParameter::Listener,
     juce::Timer
@@ -242,28 +536,42 @@ struct ResponseCurveComponent : juce::Component,
     ~ResponseCurveComponent();
 
     void parameterValueChanged(int parameterIndex, float newValue) override;
-    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override { };
+    void parameterGestureChanged(int, bool) override {}
     void timerCallback() override;
 
     void paint(juce::Graphics& g) override;
     void resized() override;
 
-    void toggleAnalysisEnablement(bool enabled)
-    {
-        shouldShowFFTAnalysis = enabled;
-    }
+    void toggleAnalysisEnablement(bool enabled);
+
+    // Analysis never runs more than once per timer tick, these decide how often below that
+    void setAnalyzerMode(AnalyzerMode mode);
+    void setAnalyzerOverlap(AnalyzerOverlap overlap);
+
+    void setAnalyzerColumnReduction(AnalyzerColumnReduction reduction);
+    void setStereoTransform(bool shouldPackChannels) { analyzerThread.setStereoTransform(shouldPackChannels); }
 private:
     TokyoEQAudioProcessor& audioProcessor;
 
     bool shouldShowFFTAnalysis = true;
 
-    juce::Atomic<bool> parametersChanged{ false };
-    MonoChain monoChain;
+    ChainCoefficients chainCoefficients;
+
+    // Each band's dB at every pixel, indexed by ChainPositions. A parameter only flags its own band,
+    // so dragging the peak never redesigns or re-evaluates the cuts.
+    static constexpr int numBands = 3;
+    std::array<std::vector<float>, numBands> bandDecibels;
+    std::array<juce::Atomic<bool>, numBands> bandChanged;
+    std::vector<int> parameterBands; // ChainPositions of each parameter index, -1 if it isn't a filter's
+
+    void markAllBandsChanged();
+    bool updateBands();
+    void updateBand(ChainPositions band, const ChainSettings& chainSettings, double sampleRate);
 
     void updateResponseCurve();
     juce::Path responseCurve;
-
-    void updateChain();
+    ResponseCurveEvaluator responseEvaluator;
+    std::vector<float> responseDecibels;
 
     //==============================================================================
 
@@ -280,6 +588,8 @@ private:
 
     PathProducer leftPathProducer, rightPathProducer;
 
+    // runs only while the analyzer is shown, declared last so it stops before the producers go
+    AnalyzerThread analyzerThread{ leftPathProducer, rightPathProducer };
 };
 //==============================================================================
 
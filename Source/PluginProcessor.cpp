@@ -20,10 +20,32 @@ TokyoEQAudioProcessor::TokyoEQAudioProcessor()
     )
 #endif
 {
+    // map every parameter to the band it redesigns, so a change only dirties that band
+    for (auto* param : getParameters())
+    {
+        auto band = -1;
+
+        if (auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+        {
+            if (paramWithID->paramID.startsWith("LowCut"))
+                band = ChainPositions::LowCut;
+            else if (paramWithID->paramID.startsWith("Peak"))
+                band = ChainPositions::Peak;
+            else if (paramWithID->paramID.startsWith("HighCut"))
+                band = ChainPositions::HighCut;
+        }
+
+        parameterBands.push_back(band);
+        param->addListener(this);
+    }
 }
 
 TokyoEQAudioProcessor::~TokyoEQAudioProcessor()
 {
+    for (auto* param : getParameters())
+    {
+        param->removeListener(this);
+    }
 }
 
 //==============================================================================
@@ -99,16 +121,27 @@ void TokyoEQAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock
     spec.numChannels = 1;
     spec.sampleRate = sampleRate;
 
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    // produce coefficients before preparing, so the filters size their state for biquads here
+    // rather than on the first audio block
+    coefficientDesigner.prepare(sampleRate);
 
-    // produce coefficients
-    updateAllFilters();
+    auto multiChannelSpec = spec;
+    multiChannelSpec.numChannels = (juce::uint32)juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    coefficientDesigner.pullCoefficients();
+    eqEngine.prepare(multiChannelSpec, coefficientDesigner.getCoefficients(), getProcessingEngine());
 
     //==============================================================================
 
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    {
+        const juce::SpinLock::ScopedLockType lock(analyzerLock);
+
+        analyzerBlockSize = samplesPerBlock;
+        analyzerSampleRate = sampleRate;
+
+        if (numAnalyzerConsumers > 0)
+            prepareAnalyzerFifos();
+    }
 
     osc.initialise([](float x) { return std::sin(x); });
 
@@ -122,6 +155,7 @@ void TokyoEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    coefficientDesigner.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -132,11 +166,9 @@ bool TokyoEQAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) c
     return true;
 #else
     // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Every channel runs the same EQ, so anything from mono up to large
+    // surround or ambisonic beds works as long as it isn't disabled.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -153,6 +185,7 @@ bool TokyoEQAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) c
 void TokyoEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    ScopedRealtimeSection realtimeSection;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -165,8 +198,10 @@ void TokyoEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce:
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    // TO:DO - refactor -- completed
-    updateAllFilters();
+    // the designer thread does the work, this is just an index swap and a copy.
+    // Continuous values ramp towards the new design, slopes and bypasses switch now.
+    if (coefficientDesigner.pullCoefficients())
+        eqEngine.setTarget(coefficientDesigner.getCoefficients());
 
     // Audio blocks for each channel
     juce::dsp::AudioBlock<float> block(buffer);
@@ -176,17 +211,48 @@ void TokyoEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce:
     //juce::dsp::ProcessContextReplacing<float> stereoContext(block);
     //osc.process(stereoContext);
 
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
+    eqEngine.process(block, getProcessingEngine(), getControlRate());
+
+    // nothing to do with no editor open or the analyzer off, and the block is
+    // skipped rather than waited on if an editor is setting the FIFOs up right now
+    const juce::SpinLock::ScopedTryLockType analyzerScope(analyzerLock);
+
+    if (analyzerScope.isLocked() && numAnalyzerConsumers > 0)
+    {
+        leftChannelFifo.update(buffer);
+        rightChannelFifo.update(buffer);
+    }
+}
+
+void TokyoEQAudioProcessor::addAnalyzerConsumer()
+{
+    const juce::SpinLock::ScopedLockType lock(analyzerLock);
+
+    if (numAnalyzerConsumers++ == 0)
+        prepareAnalyzerFifos();
+}
+
+void TokyoEQAudioProcessor::removeAnalyzerConsumer()
+{
+    const juce::SpinLock::ScopedLockType lock(analyzerLock);
 
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    jassert(numAnalyzerConsumers > 0);
 
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
+    if (--numAnalyzerConsumers == 0)
+    {
+        leftChannelFifo.release();
+        rightChannelFifo.release();
+    }
+}
 
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+void TokyoEQAudioProcessor::prepareAnalyzerFifos()
+{
+    // before the first prepareToPlay there's nothing to size them for yet
+    if (analyzerBlockSize > 0 && analyzerSampleRate > 0.0)
+    {
+        leftChannelFifo.prepare(analyzerBlockSize, analyzerSampleRate);
+        rightChannelFifo.prepare(analyzerBlockSize, analyzerSampleRate);
+    }
 }
 
 //==============================================================================
@@ -206,8 +272,11 @@ juce::AudioProcessorEditor* TokyoEQAudioProcessor::createEditor()
 void TokyoEQAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     // store parameters in the memory block.
+    auto state = apvts.copyState();
+    state.setProperty(processingEngineProperty, (int)getProcessingEngine(), nullptr);
+
     juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    state.writeToStream(mos);
 }
 
 void TokyoEQAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
@@ -216,92 +285,26 @@ void TokyoEQAudioProcessor::setStateInformation(const void* data, int sizeInByte
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if (tree.isValid())
     {
+        if (tree.hasProperty(processingEngineProperty))
+        {
+            auto engine = juce::jlimit(0, (int)ProcessingEngine::StateVariable, (int)tree.getProperty(processingEngineProperty));
+            setProcessingEngine(static_cast<ProcessingEngine>(engine));
+        }
+
         apvts.replaceState(tree);
-        updateAllFilters();
+        coefficientDesigner.markAllBandsChanged();
     }
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts) // init params
-{
-
-    ChainSettings settings;
-
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
-
-    settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load() > 0.5f;
-    settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
-    settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load() > 0.5f;
-
-    return settings;
-}
-
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-        chainSettings.peakFreq,
-        chainSettings.peakQuality,
-        juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
-}
-
-void TokyoEQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
-{
-
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-
-}
-
-void updateCoefficients(Coefficients& old, const Coefficients& replacements)
-{
-    // reference counted obj allocated on heap, needs derefference
-    *old = *replacements;
-}
-
-void TokyoEQAudioProcessor::updateLowCutFilters(const ChainSettings& chainSettings)
+void TokyoEQAudioProcessor::parameterValueChanged(int parameterIndex, float)
 {
-    auto cutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-
-    updateCutFilter(rightLowCut, cutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(leftLowCut, cutCoefficients, chainSettings.lowCutSlope);
-}
-
-void TokyoEQAudioProcessor::updateHighCutFilters(const ChainSettings& chainSettings)
-{
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
-
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
-
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
-}
-
-void TokyoEQAudioProcessor::updateAllFilters()
-{
-    auto chainSettings = getChainSettings(apvts);
+    if (juce::isPositiveAndBelow(parameterIndex, (int)parameterBands.size()))
+    {
+        auto band = parameterBands[(size_t)parameterIndex];
 
-    updateLowCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilters(chainSettings);
+        if (band >= 0)
+            coefficientDesigner.markBandChanged(static_cast<ChainPositions>(band));
+    }
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout TokyoEQAudioProcessor::createParameterLayout()
@@ -349,6 +352,17 @@ juce::AudioProcessorValueTreeState::ParameterLayout TokyoEQAudioProcessor::creat
     layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed", "HighCut Bypassed", false));
     layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Enabled", "Analyzer Enabled", true));
 
+    // FFT size, in the order of the editor's AnalyzerResolution
+    juce::StringArray resolutions{ "Auto", "2048", "4096", "8192", "Multi-resolution" };
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Resolution", "Analyzer Resolution", resolutions, 1));
+
+    // in the order of the editor's AnalyzerMode
+    juce::StringArray modes{ "Hopped", "Latest frame only" };
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Mode", "Analyzer Mode", modes, 0));
+
+    juce::StringArray overlaps{ "50%", "75%" };
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Analyzer Overlap", "Analyzer Overlap", overlaps, 1));
+
     return layout;
 }
 //==============================================================================
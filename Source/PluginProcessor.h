@@ -9,6 +9,14 @@
 #include <JuceHeader.h>
 
 #include <array>
+
+#include "FilterDesign.h"
+#include "FilterChain.h"
+#include "CoefficientDesigner.h"
+#include "EQEngine.h"
+#include "RealtimeSafety.h"
+#include "SampleRing.h"
+
 template<typename T>
 struct Fifo
 {
@@ -43,7 +51,12 @@ struct Fifo
         auto write = fifo.write(1);
         if (write.blockSize1 > 0)
         {
-            buffers[write.startIndex1] = t;
+            // buffers were sized in prepare, copy into the existing storage
+            if constexpr (std::is_same_v<T, juce::AudioBuffer<float>>)
+                buffers[write.startIndex1].makeCopyOf(t, true);
+            else
+                buffers[write.startIndex1] = t;
+
             return true;
         }
 
@@ -86,158 +99,72 @@ struct SingleChannelSampleFifo
         prepared.set(false);
     }
 
+    // Audio thread: one bulk copy of the block into the ring
     void update(const BlockType& buffer)
     {
         jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse);
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        jassert(buffer.getNumChannels() > 0);
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
-        {
-            pushNextSampleIntoFifo(channelPtr[i]);
-        }
+        // mono (or any layout narrower than the analyzer) shows its last channel on both traces
+        auto channel = juce::jmin((int)channelToUse, buffer.getNumChannels() - 1);
+
+        auto written = ring.write(buffer.getReadPointer(channel), buffer.getNumSamples());
+
+        juce::ignoreUnused(written);
     }
 
-    void prepare(int bufferSize)
+    // Message thread, with the producer already kept out by the processor's analyzerLock.
+    // Waits for a consumer that's mid-read, which only ever holds the lock for one copy.
+    void prepare(int bufferSize, double sampleRate)
     {
+        const juce::SpinLock::ScopedLockType lock(consumerLock);
+
         prepared.set(false);
         size.set(bufferSize);
 
-        bufferToFill.setSize(1,             //channel
-            bufferSize,    //num samples
-            false,         //keepExistingContent
-            true,          //clear extra space
-            true);         //avoid reallocating
-        audioBufferFifo.prepare(1, bufferSize);
-        fifoIndex = 0;
+        // enough for the GUI to fall a few frames behind before anything is dropped
+        ring.prepare(juce::jmax(bufferSize * 4, (int)(sampleRate * ringLengthSeconds)));
+
         prepared.set(true);
     }
 
+    void release()
+    {
+        const juce::SpinLock::ScopedLockType lock(consumerLock);
+
+        prepared.set(false);
+        ring.release();
+    }
+
     //==============================================================================
 
-    int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
+    int getNumSamplesAvailable() const { return ring.getNumReady(); }
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
 
     //==============================================================================
 
-    bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
+    // Consumer: hold a ScopedTryLockType on this around isPrepared() and every read below,
+    // so the ring can't be rebuilt or freed underneath them. Skip the read if it isn't taken.
+    juce::SpinLock& getConsumerLock() { return consumerLock; }
+
+    // Consumer: copies up to numSamples of the oldest unread samples, returns how many
+    int pullSamples(float* destination, int numSamples) { return ring.read(destination, numSamples); }
+    int discardSamples(int numSamples) { return ring.discard(numSamples); }
 
 private:
+    static constexpr double ringLengthSeconds = 0.1;
+
     Channel channelToUse;
-    int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
-    BlockType bufferToFill;
+    SampleRing ring;
+    juce::SpinLock consumerLock;
     juce::Atomic<bool> prepared = false;
     juce::Atomic<int> size = 0;
-
-    void pushNextSampleIntoFifo(float sample)
-    {
-        if (fifoIndex == bufferToFill.getNumSamples())
-        {
-            auto ok = audioBufferFifo.push(bufferToFill);
-
-            juce::ignoreUnused(ok);
-
-            fifoIndex = 0;
-        }
-
-        bufferToFill.setSample(0, fifoIndex, sample);
-        ++fifoIndex;
-    }
-};
-enum Slope // slope amount
-{
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
-};
-
-struct ChainSettings // Data structure for all param values
-{
-    float peakFreq{ 0 }, peakGainInDecibels{ 0 }, peakQuality{ 1.f };
-    float lowCutFreq{ 0 }, highCutFreq{ 0 };
-
-    Slope lowCutSlope{ Slope::Slope_12 }, highCutSlope{ Slope::Slope_12 };
-
-    bool lowCutBypassed{ false }, peakBypassed{ false }, highCutBypassed{ false };
-};
-
-// Helper function to get all param values from ChainSettings
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-using Filter = juce::dsp::IIR::Filter<float>;
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
-
-enum ChainPositions
-{
-    LowCut,
-    Peak,
-    HighCut
 };
-
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
-
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
-
-//==============================================================================
-template<int Index, typename ChainType, typename CoefficientType>
-void update(ChainType& chain, const CoefficientType& coefficients)
-{
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
-
-//==============================================================================
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& chain, const CoefficientType& coefficients, const Slope& slope)
-{
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
-
-    // Assigning coeff to the first filter in filter chain & stop bypassing
-    switch (slope)
-    {
-    case Slope_48:
-    {
-        update<3>(chain, coefficients);
-    }
-    case Slope_36:
-    {
-        update<2>(chain, coefficients);
-    }
-    case Slope_24:
-    {
-        update<1>(chain, coefficients);
-    }
-    case Slope_12:
-    {
-        update<0>(chain, coefficients);
-    }
-    }
-}
-//==============================================================================
-
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq, sampleRate,
-        2 * (chainSettings.lowCutSlope + 1));
-}
-
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq, sampleRate,
-        2 * (chainSettings.highCutSlope + 1));
-}
-
-
 /**
 */
-class TokyoEQAudioProcessor : public juce::AudioProcessor
+class TokyoEQAudioProcessor : public juce::AudioProcessor,
+    juce::AudioProcessorParameter::Listener
 {
 public:
     //==============================================================================
@@ -254,6 +181,22 @@ public:
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+    //==============================================================================
+    using ProcessingEngine = EQEngine::ProcessingEngine;
+
+    // Takes effect at the start of the next block, the engine switched to starts from silence.
+    // Saved with the plugin state, so each instance keeps its own engine.
+    void setProcessingEngine(ProcessingEngine newEngine) { requestedEngine.set(newEngine); }
+    ProcessingEngine getProcessingEngine() const { return static_cast<ProcessingEngine>(requestedEngine.get()); }
+
+    // While a parameter ramps, coefficients are redesigned every this many samples (16, 32, 64...)
+    void setControlRate(int numSamples) { controlRate.set(juce::jmax(1, numSamples)); }
+    int getControlRate() const { return controlRate.get(); }
+
+    //==============================================================================
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -286,18 +229,36 @@ public:
     SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left };
     SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right };
 
+    // Message thread: the channel FIFOs only exist, and processBlock only fills them,
+    // while at least one analyzer is registered
+    void addAnalyzerConsumer();
+    void removeAnalyzerConsumer();
+
 
 private:
 
-    MonoChain leftChain, rightChain;
+    // the whole filter path, sized in prepareToPlay for every channel
+    EQEngine eqEngine;
+
+    static constexpr const char* processingEngineProperty = "ProcessingEngine";
+    juce::Atomic<int> requestedEngine{ ProcessingEngine::FusedCascade };
+    juce::Atomic<int> controlRate{ 32 };
 
-    void updatePeakFilter(const ChainSettings& chainSettings);
+    //==============================================================================
+    // guards the analyzer FIFOs' lifetime, processBlock only ever try-locks it
+    juce::SpinLock analyzerLock;
+    int numAnalyzerConsumers = 0;
+    int analyzerBlockSize = 0;
+    double analyzerSampleRate = 0.0;
 
+    void prepareAnalyzerFifos();
 
     //==============================================================================
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
-    void updateAllFilters();
+    // Which band (ChainPositions) each parameter index belongs to, -1 if none
+    std::vector<int> parameterBands;
+
+    // designs off the audio thread, processBlock only picks up the result
+    CoefficientDesigner coefficientDesigner{ apvts };
 
     juce::dsp::Oscillator<float> osc;
     //==============================================================================
@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+    Debug mode that fails loudly when the audio thread allocates, locks or
+    sleeps.
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#if TOKYOEQ_REALTIME_CHECKS
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <errno.h>
+ #include <execinfo.h>
+ #include <pthread.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+namespace
+{
+    // initial-exec TLS, so reading it from inside malloc can't itself allocate
+#if JUCE_LINUX
+    __attribute__((tls_model("initial-exec")))
+#endif
+    thread_local int realtimeDepth = 0;
+
+    [[noreturn]] void failRealtimeCheck(const char* what) noexcept
+    {
+        // leave the section so reporting doesn't trip over itself, and keep off the heap
+        realtimeDepth = 0;
+
+        const char prefix[] = "TokyoEQ realtime check failed: ";
+        const char suffix[] = " called inside a realtime section\n";
+
+#if JUCE_LINUX
+        auto ignored = ::write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+        ignored = ::write(STDERR_FILENO, what, std::strlen(what));
+        ignored = ::write(STDERR_FILENO, suffix, sizeof(suffix) - 1);
+        juce::ignoreUnused(ignored);
+
+        void* frames[64];
+        ::backtrace_symbols_fd(frames, ::backtrace(frames, 64), STDERR_FILENO);
+#else
+        std::fputs(prefix, stderr);
+        std::fputs(what, stderr);
+        std::fputs(suffix, stderr);
+#endif
+
+        std::abort();
+    }
+
+    inline void checkRealtime(const char* what) noexcept
+    {
+        if (realtimeDepth > 0)
+            failRealtimeCheck(what);
+    }
+
+    void* allocate(std::size_t size, const char* what)
+    {
+        checkRealtime(what);
+
+        if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+            return ptr;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment, const char* what)
+    {
+        checkRealtime(what);
+
+#if JUCE_WINDOWS
+        if (auto* ptr = _aligned_malloc(size == 0 ? 1 : size, (std::size_t)alignment))
+            return ptr;
+#else
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, juce::jmax(sizeof(void*), (std::size_t)alignment), size == 0 ? 1 : size) == 0)
+            return ptr;
+#endif
+
+        throw std::bad_alloc();
+    }
+
+    void release(void* ptr, const char* what) noexcept
+    {
+        if (ptr != nullptr)
+        {
+            checkRealtime(what);
+            std::free(ptr);
+        }
+    }
+
+    void releaseAligned(void* ptr, const char* what) noexcept
+    {
+        if (ptr != nullptr)
+        {
+            checkRealtime(what);
+#if JUCE_WINDOWS
+            _aligned_free(ptr);
+#else
+            std::free(ptr);
+#endif
+        }
+    }
+}
+
+void enterRealtimeSection() noexcept { ++realtimeDepth; }
+void exitRealtimeSection() noexcept  { --realtimeDepth; }
+
+//==============================================================================
+void* operator new(std::size_t size)                                        { return allocate(size, "operator new"); }
+void* operator new[](std::size_t size)                                      { return allocate(size, "operator new[]"); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept        { try { return allocate(size, "operator new"); } catch (...) { return nullptr; } }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept      { try { return allocate(size, "operator new[]"); } catch (...) { return nullptr; } }
+void* operator new(std::size_t size, std::align_val_t alignment)            { return allocateAligned(size, alignment, "operator new"); }
+void* operator new[](std::size_t size, std::align_val_t alignment)          { return allocateAligned(size, alignment, "operator new[]"); }
+
+void operator delete(void* ptr) noexcept                                    { release(ptr, "operator delete"); }
+void operator delete[](void* ptr) noexcept                                  { release(ptr, "operator delete[]"); }
+void operator delete(void* ptr, std::size_t) noexcept                       { release(ptr, "operator delete"); }
+void operator delete[](void* ptr, std::size_t) noexcept                     { release(ptr, "operator delete[]"); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept             { release(ptr, "operator delete"); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept           { release(ptr, "operator delete[]"); }
+void operator delete(void* ptr, std::align_val_t) noexcept                  { releaseAligned(ptr, "operator delete"); }
+void operator delete[](void* ptr, std::align_val_t) noexcept                { releaseAligned(ptr, "operator delete[]"); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept     { releaseAligned(ptr, "operator delete"); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept   { releaseAligned(ptr, "operator delete[]"); }
+
+//==============================================================================
+#if JUCE_LINUX
+/*
+ Interposed C allocation, locking and sleeping. The allocators forward to
+ glibc's __libc_* entry points, the rest to the next definition in link order,
+ looked up during static initialisation so a realtime thread never has to.
+ */
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace
+{
+    template<typename FunctionType>
+    FunctionType* findNext(FunctionType*& cached, const char* name) noexcept
+    {
+        if (cached == nullptr)
+            cached = reinterpret_cast<FunctionType*>(::dlsym(RTLD_NEXT, name));
+
+        return cached;
+    }
+
+    decltype(pthread_mutex_lock)* nextMutexLock = nullptr;
+    decltype(pthread_cond_wait)* nextCondWait = nullptr;
+    decltype(pthread_cond_timedwait)* nextCondTimedWait = nullptr;
+    decltype(nanosleep)* nextNanosleep = nullptr;
+    decltype(usleep)* nextUsleep = nullptr;
+
+    struct NextFunctionResolver
+    {
+        NextFunctionResolver()
+        {
+            findNext(nextMutexLock, "pthread_mutex_lock");
+            findNext(nextCondWait, "pthread_cond_wait");
+            findNext(nextCondTimedWait, "pthread_cond_timedwait");
+            findNext(nextNanosleep, "nanosleep");
+            findNext(nextUsleep, "usleep");
+        }
+    };
+
+    const NextFunctionResolver nextFunctionResolver;
+}
+
+extern "C"
+{
+    void* malloc(size_t size) noexcept
+    {
+        checkRealtime("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        checkRealtime("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* ptr, size_t size) noexcept
+    {
+        checkRealtime("realloc");
+        return __libc_realloc(ptr, size);
+    }
+
+    void* memalign(size_t alignment, size_t size) noexcept
+    {
+        checkRealtime("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        checkRealtime("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, size_t alignment, size_t size) noexcept
+    {
+        checkRealtime("posix_memalign");
+
+        *result = __libc_memalign(alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    void free(void* ptr) noexcept
+    {
+        if (ptr != nullptr)
+            checkRealtime("free");
+
+        __libc_free(ptr);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        checkRealtime("pthread_mutex_lock");
+        return findNext(nextMutexLock, "pthread_mutex_lock")(mutex);
+    }
+
+    int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        checkRealtime("pthread_cond_wait");
+        return findNext(nextCondWait, "pthread_cond_wait")(condition, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* timeout)
+    {
+        checkRealtime("pthread_cond_timedwait");
+        return findNext(nextCondTimedWait, "pthread_cond_timedwait")(condition, mutex, timeout);
+    }
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        checkRealtime("nanosleep");
+        return findNext(nextNanosleep, "nanosleep")(duration, remaining);
+    }
+
+    int usleep(useconds_t microseconds)
+    {
+        checkRealtime("usleep");
+        return findNext(nextUsleep, "usleep")(microseconds);
+    }
+}
+#endif
+
+#endif
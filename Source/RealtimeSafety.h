@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+    Debug mode that fails loudly when the audio thread allocates, locks or
+    sleeps.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Set to 1 in a test or debug configuration to enforce ScopedRealtimeSection
+#ifndef TOKYOEQ_REALTIME_CHECKS
+ #define TOKYOEQ_REALTIME_CHECKS 0
+#endif
+
+#if TOKYOEQ_REALTIME_CHECKS
+void enterRealtimeSection() noexcept;
+void exitRealtimeSection() noexcept;
+#else
+inline void enterRealtimeSection() noexcept {}
+inline void exitRealtimeSection() noexcept {}
+#endif
+
+/**
+ Marks the calling thread as realtime while it's in scope. processBlock opens
+ one, and so does anything else standing in for it, like the benchmark.
+
+ With TOKYOEQ_REALTIME_CHECKS=1 the build replaces operator new and delete,
+ and on Linux also interposes malloc, free, mutex locks, condition waits and
+ sleeps. Any of those on a thread inside a section prints what happened (with
+ a backtrace where available) and aborts. Interposing only catches calls that
+ bind to this binary's definitions, so run it from an executable such as the
+ benchmark's Debug build. Without the flag this compiles to nothing.
+ */
+struct ScopedRealtimeSection
+{
+    ScopedRealtimeSection() noexcept  { enterRealtimeSection(); }
+    ~ScopedRealtimeSection() noexcept { exitRealtimeSection(); }
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+};
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+    Wakeup that the audio thread can send without taking a lock.
+  ==============================================================================
+*/
+
+#include "RealtimeSignal.h"
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID
+ #include <errno.h>
+ #include <time.h>
+#elif JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#endif
+
+RealtimeSignal::RealtimeSignal()
+{
+#if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID
+    semaphoreValid = sem_init(&semaphore, 0, 0) == 0;
+#elif JUCE_MAC || JUCE_IOS
+    semaphore = (void*)dispatch_semaphore_create(0);
+#elif JUCE_WINDOWS
+    semaphore = (void*)CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr);
+#endif
+}
+
+RealtimeSignal::~RealtimeSignal()
+{
+#if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID
+    if (semaphoreValid)
+        sem_destroy(&semaphore);
+#elif JUCE_MAC || JUCE_IOS
+    if (semaphore != nullptr)
+        dispatch_release((dispatch_semaphore_t)semaphore);
+#elif JUCE_WINDOWS
+    if (semaphore != nullptr)
+        CloseHandle((HANDLE)semaphore);
+#endif
+}
+
+void RealtimeSignal::signal() noexcept
+{
+#if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID
+    if (semaphoreValid)
+    {
+        sem_post(&semaphore);
+        return;
+    }
+#elif JUCE_MAC || JUCE_IOS
+    if (semaphore != nullptr)
+    {
+        dispatch_semaphore_signal((dispatch_semaphore_t)semaphore);
+        return;
+    }
+#elif JUCE_WINDOWS
+    if (semaphore != nullptr)
+    {
+        ReleaseSemaphore((HANDLE)semaphore, 1, nullptr);
+        return;
+    }
+#endif
+
+    pending.set(true);
+}
+
+bool RealtimeSignal::wait(int timeoutMs)
+{
+#if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID
+    if (semaphoreValid)
+    {
+        if (timeoutMs < 0)
+        {
+            while (sem_wait(&semaphore) != 0)
+                if (errno != EINTR)
+                    return false;
+
+            return true;
+        }
+
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+
+        if (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        while (sem_timedwait(&semaphore, &deadline) != 0)
+            if (errno != EINTR)
+                return false;
+
+        return true;
+    }
+#elif JUCE_MAC || JUCE_IOS
+    if (semaphore != nullptr)
+    {
+        auto timeout = timeoutMs < 0 ? DISPATCH_TIME_FOREVER
+                                     : dispatch_time(DISPATCH_TIME_NOW, (int64_t)timeoutMs * (int64_t)NSEC_PER_MSEC);
+
+        return dispatch_semaphore_wait((dispatch_semaphore_t)semaphore, timeout) == 0;
+    }
+#elif JUCE_WINDOWS
+    if (semaphore != nullptr)
+        return WaitForSingleObject((HANDLE)semaphore, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs) == WAIT_OBJECT_0;
+#endif
+
+    return pollForSignal(timeoutMs);
+}
+
+bool RealtimeSignal::pollForSignal(int timeoutMs)
+{
+    const auto start = juce::Time::getMillisecondCounter();
+
+    for (;;)
+    {
+        auto now = juce::Time::getMillisecondCounter();
+
+        if (pending.exchange(false))
+        {
+            lastSignalMs = now;
+            return true;
+        }
+
+        auto elapsed = (int)(now - start);
+
+        if (timeoutMs >= 0 && elapsed >= timeoutMs)
+            return false;
+
+        // straight after a change more are likely, so stay responsive for a while
+        auto interval = now - lastSignalMs < busyPeriodMs ? busyPollMs : idlePollMs;
+
+        if (timeoutMs >= 0)
+            interval = juce::jmin(interval, timeoutMs - elapsed);
+
+        juce::Thread::sleep(interval);
+    }
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+    Wakeup that the audio thread can send without taking a lock.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID
+ #include <semaphore.h>
+#endif
+
+/**
+ Lets one thread sleep until another has something for it, where the signalling
+ side may be the audio thread. juce::Thread::notify() locks a mutex to signal a
+ condition variable. Posting a semaphore is a single call that never waits:
+ sem_post on POSIX, dispatch_semaphore_signal on macOS, ReleaseSemaphore on
+ Windows.
+
+ Anywhere else the waiter polls a flag instead. It polls quickly for a short
+ while after the last signal and slowly once things have gone quiet, so an idle
+ instance costs only a handful of wakeups a second.
+ */
+class RealtimeSignal
+{
+public:
+    RealtimeSignal();
+    ~RealtimeSignal();
+
+    // Any thread, realtime safe. Signals sent while nobody waits are kept for the next wait().
+    void signal() noexcept;
+
+    // One thread only: true once signalled, false after timeoutMs. A negative timeout waits forever.
+    bool wait(int timeoutMs);
+
+private:
+#if JUCE_LINUX || JUCE_BSD || JUCE_ANDROID
+    sem_t semaphore;
+    bool semaphoreValid = false;
+#elif JUCE_MAC || JUCE_IOS || JUCE_WINDOWS
+    void* semaphore = nullptr;
+#endif
+
+    // the polling fallback, also used if the semaphore couldn't be created
+    bool pollForSignal(int timeoutMs);
+
+    juce::Atomic<bool> pending{ false };
+    juce::uint32 lastSignalMs = 0;
+
+    static constexpr int busyPollMs = 5;
+    static constexpr int idlePollMs = 100;
+    static constexpr juce::uint32 busyPeriodMs = 1000;
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeSignal)
+};
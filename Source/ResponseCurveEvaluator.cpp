@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+    Batch magnitude response of the filter chain, for drawing the response
+    curve.
+  ==============================================================================
+*/
+
+#include "ResponseCurveEvaluator.h"
+
+#include "SpectrumMath.h"
+
+#include <array>
+#include <cmath>
+
+namespace
+{
+    // |H|^2 = (n0 + n1 phi + n2 phi^2) / (d0 + d1 phi + d2 phi^2)
+    struct PowerSection
+    {
+        float n0, n1, n2, d0, d1, d2;
+    };
+
+    PowerSection makePowerSection(const BiquadCoefficients& c)
+    {
+        const double b0 = c.b0, b1 = c.b1, b2 = c.b2, a1 = c.a1, a2 = c.a2;
+
+        return { (float)((b0 + b1 + b2) * (b0 + b1 + b2)),
+                 (float)(-4.0 * (b0 * b1 + 4.0 * b0 * b2 + b1 * b2)),
+                 (float)(16.0 * b0 * b2),
+                 (float)((1.0 + a1 + a2) * (1.0 + a1 + a2)),
+                 (float)(-4.0 * (a1 + 4.0 * a2 + a1 * a2)),
+                 (float)(16.0 * a2) };
+    }
+
+    constexpr float floorPower = 1.0e-10f;                 // -100 dB
+    constexpr float decibelsPerPowerOctave = 3.01029996f;  // 10 log10(2)
+
+    // enough points to stay in L1 while every section passes over them
+    constexpr int blockSize = 256;
+
+    // room for a full chain, two cuts of four sections and the peak
+    constexpr int maxSectionsPerBand = 4;
+    constexpr int maxSections = 2 * maxSectionsPerBand + 1;
+
+    // the same sections of one band that the processing chain enables
+    int getActiveSections(const ChainCoefficients& coefficients, ChainPositions band, BiquadCoefficients* sections)
+    {
+        const auto& settings = coefficients.settings;
+        int numSections = 0;
+
+        switch (band)
+        {
+            case LowCut:
+                if (!settings.lowCutBypassed)
+                    for (int i = 0; i <= (int)settings.lowCutSlope; ++i)
+                        sections[numSections++] = coefficients.lowCut[(size_t)i];
+                break;
+
+            case Peak:
+                if (!settings.peakBypassed)
+                    sections[numSections++] = coefficients.peak;
+                break;
+
+            case HighCut:
+                if (!settings.highCutBypassed)
+                    for (int i = 0; i <= (int)settings.highCutSlope; ++i)
+                        sections[numSections++] = coefficients.highCut[(size_t)i];
+                break;
+        }
+
+        return numSections;
+    }
+}
+
+bool ResponseCurveEvaluator::prepare(int numPoints, double sampleRate)
+{
+    numPoints = juce::jmax(0, numPoints);
+
+    if (numPoints == preparedPoints && sampleRate == preparedSampleRate)
+        return false;
+
+    preparedPoints = numPoints;
+    preparedSampleRate = sampleRate;
+
+    phi.resize((size_t)numPoints);
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto freq = juce::mapToLog10(double(i) / double(numPoints), 20.0, 20000.0);
+        auto s = std::sin(juce::MathConstants<double>::pi * freq / sampleRate);   // sin(w / 2)
+        phi[(size_t)i] = (float)(s * s);
+    }
+
+    return true;
+}
+
+void ResponseCurveEvaluator::evaluate(const BiquadCoefficients* sections, int numSections, float* decibels) const noexcept
+{
+    jassert(numSections <= maxSections);
+    numSections = juce::jmin(numSections, maxSections);
+
+    std::array<PowerSection, maxSections> powerSections;
+
+    for (int s = 0; s < numSections; ++s)
+        powerSections[(size_t)s] = makePowerSection(sections[s]);
+
+    const auto numPoints = getNumPoints();
+
+    for (int start = 0; start < numPoints; start += blockSize)
+    {
+        const auto count = juce::jmin(blockSize, numPoints - start);
+        const auto* p = phi.data() + start;
+
+        float power[blockSize];
+        std::fill(power, power + count, 1.f);
+
+        // each loop is branch free over the points, so the compiler vectorises it.
+        // Flooring as it goes keeps deep stopbands from going denormal.
+        for (int s = 0; s < numSections; ++s)
+        {
+            const auto& ps = powerSections[(size_t)s];
+
+            for (int i = 0; i < count; ++i)
+            {
+                const auto numerator = ps.n0 + p[i] * (ps.n1 + p[i] * ps.n2);
+                const auto denominator = ps.d0 + p[i] * (ps.d1 + p[i] * ps.d2);
+
+                power[i] = juce::jmax(floorPower, power[i] * (numerator / denominator));
+            }
+        }
+
+        for (int i = 0; i < count; ++i)
+            decibels[start + i] = decibelsPerPowerOctave * fastLog2(power[i]);
+    }
+}
+
+void ResponseCurveEvaluator::evaluate(const ChainCoefficients& coefficients, float* decibels) const noexcept
+{
+    std::array<BiquadCoefficients, maxSections> sections;
+    int numSections = 0;
+
+    for (auto band : { LowCut, Peak, HighCut })
+        numSections += getActiveSections(coefficients, band, sections.data() + numSections);
+
+    evaluate(sections.data(), numSections, decibels);
+}
+
+void ResponseCurveEvaluator::evaluate(const ChainCoefficients& coefficients, ChainPositions band, float* decibels) const noexcept
+{
+    std::array<BiquadCoefficients, maxSectionsPerBand> sections;
+    const auto numSections = getActiveSections(coefficients, band, sections.data());
+
+    // a bypassed band is flat, so it adds nothing when the bands are summed
+    if (numSections == 0)
+        juce::FloatVectorOperations::clear(decibels, getNumPoints());
+    else
+        evaluate(sections.data(), numSections, decibels);
+}
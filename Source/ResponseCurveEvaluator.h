@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+    Batch magnitude response of the filter chain, for drawing the response
+    curve.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+#include "FilterDesign.h"
+
+/**
+ Evaluates cascaded biquads at every point of the editor's log frequency axis
+ in one pass, instead of one getMagnitudeForFrequency call in double per
+ section per pixel.
+
+ For a real biquad, |H(e^jw)|^2 depends on w only through phi = sin^2(w / 2):
+     |H|^2 = ((b0 + b1 + b2)^2 - 4 (b0 b1 + 4 b0 b2 + b1 b2) phi + 16 b0 b2 phi^2)
+           / ((1 + a1 + a2)^2 - 4 (a1 + 4 a2 + a1 a2) phi + 16 a2 phi^2)
+ So the per-pixel table is phi alone. Each section reduces to two quadratics
+ whose coefficients are formed in double. That keeps the float evaluation
+ accurate near DC at high sample rates, where expanding e^-jw cancels badly.
+ */
+class ResponseCurveEvaluator
+{
+public:
+    // Points spaced like the editor's axis, 20 Hz to 20 kHz. Returns false, and does nothing, if they haven't changed.
+    bool prepare(int numPoints, double sampleRate);
+
+    int getNumPoints() const noexcept { return (int)phi.size(); }
+
+    // dB of the sections in cascade at every point, floored at -100 dB like Decibels::gainToDecibels
+    void evaluate(const BiquadCoefficients* sections, int numSections, float* decibels) const noexcept;
+
+    // The whole chain, with the active sections picked from the slopes and bypass states in 'coefficients.settings'
+    void evaluate(const ChainCoefficients& coefficients, float* decibels) const noexcept;
+
+    // One band of the chain on its own. The chain's response is the sum of its bands' dB, so callers can cache
+    // these per band and only redo the one whose parameters moved.
+    void evaluate(const ChainCoefficients& coefficients, ChainPositions band, float* decibels) const noexcept;
+
+private:
+    std::vector<float> phi;
+    int preparedPoints = 0;
+    double preparedSampleRate = 0.0;
+};
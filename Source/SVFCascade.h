@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+    Zero-delay-feedback state variable alternative to BiquadCascade.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <type_traits>
+
+#include "FilterDesign.h"
+
+/**
+ The same LowCut / Peak / HighCut layout as BiquadCascade, built from
+ Cytomic-style trapezoidal SVF sections. The state is the integrator
+ charge rather than past outputs, so the response stays well behaved when
+ peakFreq or peakQuality are swept quickly, and setting it up only takes one
+ tan() per band, cheap enough to redesign at a very short control rate.
+
+ Packing, state relocation and the per-section-count specialisations work
+ exactly like BiquadCascade.
+ */
+template<typename SampleType>
+struct SVFCascade
+{
+    // four low cut stages, the peak and four high cut stages
+    static constexpr int maxSections = 9;
+
+    void setCoefficients(const ChainSettings& chainSettings, double sampleRate)
+    {
+        std::array<int, maxSections> newSlots{};
+        int newNumSections = 0;
+
+        auto add = [this, &newSlots, &newNumSections](int slot, const SVFCoefficients& svf)
+        {
+            auto& section = sections[(size_t)newNumSections];
+            section.a1 = broadcast(svf.a1);
+            section.a2 = broadcast(svf.a2);
+            section.a3 = broadcast(svf.a3);
+            section.m0 = broadcast(svf.m0);
+            section.m1 = broadcast(svf.m1);
+            section.m2 = broadcast(svf.m2);
+
+            newSlots[(size_t)newNumSections++] = slot;
+        };
+
+        if (!chainSettings.lowCutBypassed)
+        {
+            SVFCutCoefficients lowCut;
+            designSVFHighPass(lowCut, chainSettings.lowCutFreq, chainSettings.lowCutSlope, sampleRate);
+
+            for (int stage = 0; stage <= chainSettings.lowCutSlope; ++stage)
+                add(lowCutSlot + stage, lowCut[(size_t)stage]);
+        }
+
+        if (!chainSettings.peakBypassed)
+            add(peakSlot, designSVFPeak(chainSettings, sampleRate));
+
+        if (!chainSettings.highCutBypassed)
+        {
+            SVFCutCoefficients highCut;
+            designSVFLowPass(highCut, chainSettings.highCutFreq, chainSettings.highCutSlope, sampleRate);
+
+            for (int stage = 0; stage <= chainSettings.highCutSlope; ++stage)
+                add(highCutSlot + stage, highCut[(size_t)stage]);
+        }
+
+        relocateState(newSlots, newNumSections);
+    }
+
+    void reset()
+    {
+        for (auto* state : { &ic1eq, &ic2eq, &parkedIc1eq, &parkedIc2eq })
+            state->fill(SampleType());
+    }
+
+    int getNumActiveSections() const { return numSections; }
+
+    //==============================================================================
+    void process(SampleType* samples, int numSamples) noexcept
+    {
+        (this->*processFunction)(samples, numSamples);
+    }
+
+private:
+    static constexpr int lowCutSlot = 0;
+    static constexpr int peakSlot = 4;
+    static constexpr int highCutSlot = 5;
+
+    struct Section
+    {
+        SampleType a1, a2, a3, m0, m1, m2;
+    };
+
+    using ProcessFunction = void (SVFCascade::*)(SampleType*, int) noexcept;
+
+    template<int NumSections>
+    void processSections(SampleType* samples, int numSamples) noexcept
+    {
+        if constexpr (NumSections > 0)
+        {
+            std::array<SampleType, NumSections> s1, s2;
+
+            for (size_t n = 0; n < NumSections; ++n)
+            {
+                s1[n] = ic1eq[n];
+                s2[n] = ic2eq[n];
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto x = samples[i];
+
+                for (size_t n = 0; n < NumSections; ++n)
+                {
+                    const auto& section = sections[n];
+
+                    auto v3 = x - s2[n];
+                    auto v1 = section.a1 * s1[n] + section.a2 * v3;
+                    auto v2 = s2[n] + section.a2 * s1[n] + section.a3 * v3;
+
+                    s1[n] = v1 + v1 - s1[n];
+                    s2[n] = v2 + v2 - s2[n];
+
+                    x = section.m0 * x + section.m1 * v1 + section.m2 * v2;
+                }
+
+                samples[i] = x;
+            }
+
+            for (size_t n = 0; n < NumSections; ++n)
+            {
+                juce::dsp::util::snapToZero(s1[n]);
+                juce::dsp::util::snapToZero(s2[n]);
+
+                ic1eq[n] = s1[n];
+                ic2eq[n] = s2[n];
+            }
+        }
+        else
+        {
+            juce::ignoreUnused(samples, numSamples);
+        }
+    }
+
+    static ProcessFunction getProcessFunction(int numSections)
+    {
+        switch (numSections)
+        {
+        case 1: return &SVFCascade::processSections<1>;
+        case 2: return &SVFCascade::processSections<2>;
+        case 3: return &SVFCascade::processSections<3>;
+        case 4: return &SVFCascade::processSections<4>;
+        case 5: return &SVFCascade::processSections<5>;
+        case 6: return &SVFCascade::processSections<6>;
+        case 7: return &SVFCascade::processSections<7>;
+        case 8: return &SVFCascade::processSections<8>;
+        case 9: return &SVFCascade::processSections<9>;
+        default: break;
+        }
+
+        return &SVFCascade::processSections<0>;
+    }
+
+    static SampleType broadcast(float value)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            return value;
+        else
+            return SampleType::expand(value);
+    }
+
+    void relocateState(const std::array<int, maxSections>& newSlots, int newNumSections)
+    {
+        std::array<bool, maxSections> wasActive{};
+
+        for (int n = 0; n < numSections; ++n)
+        {
+            auto slot = (size_t)slots[(size_t)n];
+            parkedIc1eq[slot] = ic1eq[(size_t)n];
+            parkedIc2eq[slot] = ic2eq[(size_t)n];
+            wasActive[slot] = true;
+        }
+
+        for (int n = 0; n < newNumSections; ++n)
+        {
+            auto slot = (size_t)newSlots[(size_t)n];
+            ic1eq[(size_t)n] = wasActive[slot] ? parkedIc1eq[slot] : SampleType();
+            ic2eq[(size_t)n] = wasActive[slot] ? parkedIc2eq[slot] : SampleType();
+        }
+
+        slots = newSlots;
+        numSections = newNumSections;
+        processFunction = getProcessFunction(numSections);
+    }
+
+    std::array<Section, maxSections> sections;
+    std::array<int, maxSections> slots{};
+    int numSections = 0;
+    ProcessFunction processFunction = &SVFCascade::processSections<0>;
+
+    std::array<SampleType, maxSections> ic1eq{}, ic2eq{}, parkedIc1eq{}, parkedIc2eq{};
+};
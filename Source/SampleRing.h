@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+    Wait-free single producer / single consumer ring of float samples.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+/**
+ One thread writes whole blocks, another reads them back, and neither ever
+ waits for the other. Both sides copy in at most two contiguous runs, so a
+ block costs one vectorised copy. A write that doesn't fit is cut short and
+ the rest dropped, which for the analyzer just means a skipped stretch of
+ audio while the GUI is stalled.
+ */
+struct SampleRing
+{
+    // Not realtime safe. The owner must keep both sides out while it runs, as must release().
+    void prepare(int capacity)
+    {
+        samples.assign((size_t)capacity + 1, 0.f);
+        fifo.setTotalSize(capacity + 1);
+    }
+
+    // Frees the storage, nothing fits until the next prepare()
+    void release()
+    {
+        std::vector<float>().swap(samples);
+        fifo.setTotalSize(1);
+    }
+
+    // Producer: returns how many samples were taken
+    int write(const float* source, int numSamples)
+    {
+        auto scope = fifo.write(numSamples);
+
+        if (scope.blockSize1 > 0)
+            juce::FloatVectorOperations::copy(samples.data() + scope.startIndex1, source, scope.blockSize1);
+
+        if (scope.blockSize2 > 0)
+            juce::FloatVectorOperations::copy(samples.data() + scope.startIndex2, source + scope.blockSize1, scope.blockSize2);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    // Consumer: returns how many samples were copied out
+    int read(float* destination, int numSamples)
+    {
+        auto scope = fifo.read(numSamples);
+
+        if (scope.blockSize1 > 0)
+            juce::FloatVectorOperations::copy(destination, samples.data() + scope.startIndex1, scope.blockSize1);
+
+        if (scope.blockSize2 > 0)
+            juce::FloatVectorOperations::copy(destination + scope.blockSize1, samples.data() + scope.startIndex2, scope.blockSize2);
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    // Consumer: drops up to numSamples of the oldest unread samples without copying them
+    int discard(int numSamples)
+    {
+        auto scope = fifo.read(numSamples);
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    int getNumReady() const { return fifo.getNumReady(); }
+
+private:
+    juce::AbstractFifo fifo{ 1 };
+    std::vector<float> samples;
+};
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+    Fused per-bin kernels for turning FFT output into the analyzer's dB
+    values.
+  ==============================================================================
+*/
+
+#include "SpectrumMath.h"
+
+
+namespace
+{
+    constexpr float decibelsPerOctave = 6.02059991f;   // 20 log10(2)
+    constexpr std::int32_t oneBits = 0x3f800000;       // 1.f
+    constexpr std::int32_t infinityBits = 0x7f800000;
+
+    inline std::int32_t toBits(float x) noexcept
+    {
+        std::int32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    }
+
+    inline float fromBits(std::int32_t bits) noexcept
+    {
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    /*
+     dBPerOctave * log2(value), or negativeInfinity unless value is finite and
+     above 'floor'. Positive floats order like their bit patterns, and negative
+     ones, infinity and NaN all fall outside (floor, infinity), so one integer
+     range check covers every case.
+     The choices are bit masks rather than ?: because with GCC's default
+     -ftrapping-math a select around fastLog2's division isn't if-converted,
+     and the loop wouldn't vectorise.
+     */
+    inline float toDecibels(float value, float dBPerOctave, std::int32_t floorBits, std::int32_t negativeInfinityBits) noexcept
+    {
+        const auto bits = toBits(value);
+        const auto mask = -(std::int32_t)((bits > floorBits) & (bits < infinityBits));
+
+        const auto decibels = dBPerOctave * fastLog2(fromBits((bits & mask) | (oneBits & ~mask)));
+
+        return fromBits((toBits(decibels) & mask) | (negativeInfinityBits & ~mask));
+    }
+}
+
+void magnitudesToDecibels(const float* magnitudes, float* decibels, int numBins,
+                          float scale, float negativeInfinity) noexcept
+{
+    const auto floorBits = toBits(juce::Decibels::decibelsToGain(negativeInfinity, negativeInfinity - 1.f));
+    const auto negativeInfinityBits = toBits(negativeInfinity);
+
+    for (int i = 0; i < numBins; ++i)
+        decibels[i] = toDecibels(magnitudes[i] * scale, decibelsPerOctave, floorBits, negativeInfinityBits);
+}
+
+void packedSpectrumToDecibels(const juce::dsp::Complex<float>* spectrum, int fftSize,
+                              float* leftDecibels, float* rightDecibels, int numBins,
+                              float scale, float negativeInfinity) noexcept
+{
+    jassert(numBins <= fftSize / 2 + 1);
+
+    const auto floorGain = juce::Decibels::decibelsToGain(negativeInfinity, negativeInfinity - 1.f);
+    const auto floorBits = toBits(floorGain * floorGain);
+    const auto negativeInfinityBits = toBits(negativeInfinity);
+    const auto powerScale = 0.25f * scale * scale;   // the 1/2 from separating the channels, squared
+    const auto mask = fftSize - 1;
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        const auto bin = spectrum[k];
+        const auto mirrored = spectrum[(fftSize - k) & mask];
+
+        // X[k] + conj(X[N - k]) and X[k] - conj(X[N - k])
+        const auto sumRe = bin.real() + mirrored.real();
+        const auto sumIm = bin.imag() - mirrored.imag();
+        const auto diffRe = bin.real() - mirrored.real();
+        const auto diffIm = bin.imag() + mirrored.imag();
+
+        // power, so half the dB per doubling
+        leftDecibels[k] = toDecibels((sumRe * sumRe + sumIm * sumIm) * powerScale, 0.5f * decibelsPerOctave, floorBits, negativeInfinityBits);
+        rightDecibels[k] = toDecibels((diffRe * diffRe + diffIm * diffIm) * powerScale, 0.5f * decibelsPerOctave, floorBits, negativeInfinityBits);
+    }
+}
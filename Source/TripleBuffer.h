@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+    Wait-free single producer / single consumer hand-over of a whole object.
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+/**
+ Three preallocated slots: the producer owns one, the consumer owns one and
+ the third sits in the middle. Publishing and pulling are a single atomic
+ exchange of the middle slot index, so neither side ever blocks or allocates
+ and the consumer always gets the most recently published value.
+ */
+template<typename T>
+struct TripleBuffer
+{
+    // producer side
+    T& getWriteBuffer() { return buffers[(size_t)writeIndex]; }
+
+    void publish()
+    {
+        auto previous = middle.exchange(writeIndex | freshFlag);
+        writeIndex = previous & indexMask;
+    }
+
+    // consumer side, returns true if a newer object became readable
+    bool pull()
+    {
+        if ((middle.get() & freshFlag) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const { return buffers[(size_t)readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshFlag = 4;
+
+    std::array<T, 3> buffers;
+    int writeIndex = 0;
+    int readIndex = 1;
+    juce::Atomic<int> middle{ 2 };
+};